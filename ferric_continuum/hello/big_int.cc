@@ -0,0 +1,345 @@
+#include "big_int.hh"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace ferric {
+
+namespace {
+
+using u128 = unsigned __int128;
+
+// Below this many limbs schoolbook multiplication beats Karatsuba
+constexpr size_t kKaratsubaThreshold = 24;
+
+// r = a + b over n limbs; returns the carry out
+uint64_t add_n(uint64_t* r, const uint64_t* a, const uint64_t* b, size_t n) {
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const u128 s = static_cast<u128>(a[i]) + b[i] + carry;
+    r[i] = static_cast<uint64_t>(s);
+    carry = static_cast<uint64_t>(s >> 64);
+  }
+  return carry;
+}
+
+// r = a - b over n limbs; returns the borrow out
+uint64_t sub_n(uint64_t* r, const uint64_t* a, const uint64_t* b, size_t n) {
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const uint64_t d = a[i] - b[i];
+    const uint64_t next = (a[i] < b[i]) | (d < borrow);
+    r[i] = d - borrow;
+    borrow = next;
+  }
+  return borrow;
+}
+
+// Add carry into r[0, n); returns the carry out of the top limb
+uint64_t propagate_carry(uint64_t* r, size_t n, uint64_t carry) {
+  for (size_t i = 0; i < n && carry; ++i) {
+    r[i] += carry;
+    carry = r[i] < carry;
+  }
+  return carry;
+}
+
+// Subtract borrow from r[0, n)
+void propagate_borrow(uint64_t* r, size_t n, uint64_t borrow) {
+  for (size_t i = 0; i < n && borrow; ++i) {
+    const uint64_t before = r[i];
+    r[i] -= borrow;
+    borrow = before < borrow;
+  }
+}
+
+// r[0, na + nb) = a * b
+void mul_basecase(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+  std::fill_n(r, na + nb, 0);
+  for (size_t i = 0; i < na; ++i) {
+    uint64_t carry = 0;
+    for (size_t j = 0; j < nb; ++j) {
+      const u128 t = static_cast<u128>(a[i]) * b[j] + r[i + j] + carry;
+      r[i + j] = static_cast<uint64_t>(t);
+      carry = static_cast<uint64_t>(t >> 64);
+    }
+    r[i + nb] = carry;
+  }
+}
+
+// r[0, 2n) = a * a: each cross product a[i] * a[j] is formed once and doubled
+void sqr_basecase(uint64_t* r, const uint64_t* a, size_t n) {
+  std::fill_n(r, 2 * n, 0);
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t carry = 0;
+    for (size_t j = i + 1; j < n; ++j) {
+      const u128 t = static_cast<u128>(a[i]) * a[j] + r[i + j] + carry;
+      r[i + j] = static_cast<uint64_t>(t);
+      carry = static_cast<uint64_t>(t >> 64);
+    }
+    r[i + n] = carry;
+  }
+  uint64_t top = 0;
+  for (size_t i = 0; i < 2 * n; ++i) {
+    const uint64_t next = r[i] >> 63;
+    r[i] = r[i] << 1 | top;
+    top = next;
+  }
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const u128 sq = static_cast<u128>(a[i]) * a[i];
+    const u128 lo = static_cast<u128>(r[2 * i]) + static_cast<uint64_t>(sq) + carry;
+    r[2 * i] = static_cast<uint64_t>(lo);
+    const u128 hi = static_cast<u128>(r[2 * i + 1]) + static_cast<uint64_t>(sq >> 64) +
+                    static_cast<uint64_t>(lo >> 64);
+    r[2 * i + 1] = static_cast<uint64_t>(hi);
+    carry = static_cast<uint64_t>(hi >> 64);
+  }
+}
+
+// r[0, n) = |a - b| where a has n limbs and b has m <= n; returns whether a < b
+bool abs_diff(uint64_t* r, const uint64_t* a, size_t n, const uint64_t* b, size_t m) {
+  size_t i = n;
+  bool a_less = false;
+  while (i-- > 0) {
+    const uint64_t bi = i < m ? b[i] : 0;
+    if (a[i] != bi) {
+      a_less = a[i] < bi;
+      break;
+    }
+  }
+  if (a_less) {
+    // b < 2^(64 m) here, so the high limbs of a are zero
+    sub_n(r, b, a, m);
+    std::fill(r + m, r + n, 0);
+  } else {
+    const uint64_t borrow = sub_n(r, a, b, m);
+    std::copy(a + m, a + n, r + m);
+    propagate_borrow(r + m, n - m, borrow);
+  }
+  return a_less;
+}
+
+// Scratch limbs needed by karatsuba() for operands of n limbs
+size_t karatsuba_scratch(size_t n) {
+  size_t total = 0;
+  while (n >= kKaratsubaThreshold) {
+    const size_t high = n - n / 2;
+    total += 6 * high + 1;
+    n = high;
+  }
+  return total;
+}
+
+// r[0, 2n) = a * b for n-limb operands (squares when a == b).
+//
+// Subtractive Karatsuba: with a = a1 B + a0 and b = b1 B + b0,
+// a b = z2 B^2 + (z0 + z2 - (a1 - a0)(b1 - b0)) B + z0, where the middle
+// product works on absolute differences so no operand grows a carry limb.
+void karatsuba(uint64_t* r, const uint64_t* a, const uint64_t* b, size_t n, uint64_t* scratch) {
+  const bool square = a == b;
+  if (n < kKaratsubaThreshold) {
+    square ? sqr_basecase(r, a, n) : mul_basecase(r, a, n, b, n);
+    return;
+  }
+  const size_t low = n / 2;
+  const size_t high = n - low;
+  uint64_t* da = scratch;
+  uint64_t* db = da + high;
+  uint64_t* middle = db + high;       // 2 * high limbs
+  uint64_t* sum = middle + 2 * high;  // 2 * high + 1 limbs
+  uint64_t* rest = sum + 2 * high + 1;
+
+  bool negative = abs_diff(da, a + low, high, a, low);
+  if (square) {
+    negative = false;
+    db = da;
+  } else {
+    negative ^= abs_diff(db, b + low, high, b, low);
+  }
+
+  karatsuba(r, a, square ? a : b, low, rest);  // z0
+  karatsuba(r + 2 * low, a + low, square ? a + low : b + low, high, rest);  // z2
+  karatsuba(middle, da, db, high, rest);
+
+  // sum = z0 + z2 -/+ middle, which is the (nonnegative) middle coefficient
+  std::copy(r + 2 * low, r + 2 * n, sum);
+  sum[2 * high] =
+      propagate_carry(sum + 2 * low, 2 * (high - low), add_n(sum, sum, r, 2 * low));
+  if (negative) {
+    sum[2 * high] += add_n(sum, sum, middle, 2 * high);
+  } else {
+    sum[2 * high] -= sub_n(sum, sum, middle, 2 * high);
+  }
+  propagate_carry(r + low + 2 * high + 1, 2 * n - low - 2 * high - 1,
+                  add_n(r + low, r + low, sum, 2 * high + 1));
+}
+
+// r[0, na + nb) = a * b
+void multiply(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+  if (na < nb) {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  if (nb < kKaratsubaThreshold) {
+    mul_basecase(r, a, na, b, nb);
+    return;
+  }
+  if (a == b && na == nb) {
+    std::vector<uint64_t> scratch(karatsuba_scratch(na));
+    karatsuba(r, a, a, na, scratch.data());
+    return;
+  }
+  // Multiply a in balanced nb-limb blocks and accumulate
+  std::fill_n(r, na + nb, 0);
+  std::vector<uint64_t> scratch(karatsuba_scratch(nb));
+  std::vector<uint64_t> block(2 * nb);
+  size_t i = 0;
+  for (; i + nb <= na; i += nb) {
+    karatsuba(block.data(), a + i, b, nb, scratch.data());
+    propagate_carry(r + i + 2 * nb, na - i - nb, add_n(r + i, r + i, block.data(), 2 * nb));
+  }
+  if (i < na) {
+    const size_t tail = na - i;
+    multiply(block.data(), b, nb, a + i, tail);
+    add_n(r + i, r + i, block.data(), nb + tail);  // Ends at the top limb, so no carry out
+  }
+}
+
+}  // namespace
+
+BigUint::BigUint(uint64_t value) {
+  if (value) {
+    limbs_.push_back(value);
+  }
+}
+
+void BigUint::trim() {
+  while (!limbs_.empty() && limbs_.back() == 0) {
+    limbs_.pop_back();
+  }
+}
+
+size_t BigUint::bit_width() const {
+  return limbs_.empty() ? 0 : 64 * (limbs_.size() - 1) + std::bit_width(limbs_.back());
+}
+
+std::string BigUint::to_string() const {
+  if (limbs_.empty()) {
+    return "0";
+  }
+  // Peel off 19 decimal digits at a time by dividing by 10^19
+  constexpr uint64_t kChunk = 10000000000000000000ULL;
+  std::vector<uint64_t> rest = limbs_;
+  std::vector<uint64_t> chunks;
+  while (!rest.empty()) {
+    uint64_t remainder = 0;
+    for (size_t i = rest.size(); i-- > 0;) {
+      const u128 cur = static_cast<u128>(remainder) << 64 | rest[i];
+      rest[i] = static_cast<uint64_t>(cur / kChunk);
+      remainder = static_cast<uint64_t>(cur % kChunk);
+    }
+    chunks.push_back(remainder);
+    while (!rest.empty() && rest.back() == 0) {
+      rest.pop_back();
+    }
+  }
+  std::string digits = std::to_string(chunks.back());
+  for (size_t i = chunks.size() - 1; i-- > 0;) {
+    const std::string chunk = std::to_string(chunks[i]);
+    digits.append(19 - chunk.size(), '0');
+    digits += chunk;
+  }
+  return digits;
+}
+
+BigUint& BigUint::operator+=(const BigUint& other) {
+  if (limbs_.size() < other.limbs_.size()) {
+    limbs_.resize(other.limbs_.size(), 0);
+  }
+  const size_t n = other.limbs_.size();
+  uint64_t carry = add_n(limbs_.data(), limbs_.data(), other.limbs_.data(), n);
+  carry = propagate_carry(limbs_.data() + n, limbs_.size() - n, carry);
+  if (carry) {
+    limbs_.push_back(carry);
+  }
+  return *this;
+}
+
+BigUint& BigUint::operator-=(const BigUint& other) {
+  if (*this < other) {
+    throw std::invalid_argument("BigUint: subtraction would be negative");
+  }
+  const size_t n = other.limbs_.size();
+  propagate_borrow(limbs_.data() + n, limbs_.size() - n,
+                   sub_n(limbs_.data(), limbs_.data(), other.limbs_.data(), n));
+  trim();
+  return *this;
+}
+
+BigUint& BigUint::operator*=(const BigUint& other) {
+  *this = *this * other;
+  return *this;
+}
+
+BigUint operator*(const BigUint& a, const BigUint& b) {
+  BigUint product;
+  if (a.is_zero() || b.is_zero()) {
+    return product;
+  }
+  product.limbs_.resize(a.limbs_.size() + b.limbs_.size());
+  multiply(product.limbs_.data(), a.limbs_.data(), a.limbs_.size(), b.limbs_.data(),
+           b.limbs_.size());
+  product.trim();
+  return product;
+}
+
+BigUint& BigUint::operator<<=(size_t bits) {
+  if (limbs_.empty()) {
+    return *this;
+  }
+  const size_t words = bits / 64;
+  const unsigned shift = bits % 64;
+  if (shift) {
+    uint64_t top = 0;
+    for (uint64_t& limb : limbs_) {
+      const uint64_t next = limb >> (64 - shift);
+      limb = limb << shift | top;
+      top = next;
+    }
+    if (top) {
+      limbs_.push_back(top);
+    }
+  }
+  limbs_.insert(limbs_.begin(), words, 0);
+  return *this;
+}
+
+BigUint& BigUint::operator>>=(size_t bits) {
+  const size_t words = bits / 64;
+  if (words >= limbs_.size()) {
+    limbs_.clear();
+    return *this;
+  }
+  limbs_.erase(limbs_.begin(), limbs_.begin() + words);
+  const unsigned shift = bits % 64;
+  if (shift) {
+    for (size_t i = 0; i + 1 < limbs_.size(); ++i) {
+      limbs_[i] = limbs_[i] >> shift | limbs_[i + 1] << (64 - shift);
+    }
+    limbs_.back() >>= shift;
+    trim();
+  }
+  return *this;
+}
+
+std::strong_ordering operator<=>(const BigUint& a, const BigUint& b) {
+  if (a.limbs_.size() != b.limbs_.size()) {
+    return a.limbs_.size() <=> b.limbs_.size();
+  }
+  return std::lexicographical_compare_three_way(a.limbs_.rbegin(), a.limbs_.rend(),
+                                                b.limbs_.rbegin(), b.limbs_.rend());
+}
+
+}  // namespace ferric
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ferric {
+
+// Arbitrary-precision unsigned integer.
+//
+// The value is a little-endian vector of 64-bit limbs with no leading zero
+// limbs, so zero has no limbs at all. Products switch from schoolbook to
+// Karatsuba multiplication above a few dozen limbs, and squaring takes a
+// cheaper path that shares the symmetric partial products.
+class BigUint {
+ public:
+  BigUint() = default;
+  explicit BigUint(uint64_t value);
+
+  bool is_zero() const { return limbs_.empty(); }
+
+  // Little-endian limbs, most significant limb nonzero
+  std::span<const uint64_t> limbs() const { return limbs_; }
+
+  // Number of bits needed to represent the value (0 for zero)
+  size_t bit_width() const;
+
+  // Decimal digits; quadratic in the length, meant for values up to ~10^5 digits
+  std::string to_string() const;
+
+  BigUint& operator+=(const BigUint& other);
+  // Throws std::invalid_argument if other is larger than *this
+  BigUint& operator-=(const BigUint& other);
+  BigUint& operator*=(const BigUint& other);
+  BigUint& operator<<=(size_t bits);
+  BigUint& operator>>=(size_t bits);
+
+  friend BigUint operator+(BigUint a, const BigUint& b) { return a += b; }
+  friend BigUint operator-(BigUint a, const BigUint& b) { return a -= b; }
+  friend BigUint operator*(const BigUint& a, const BigUint& b);
+  friend BigUint operator<<(BigUint a, size_t bits) { return a <<= bits; }
+  friend BigUint operator>>(BigUint a, size_t bits) { return a >>= bits; }
+
+  friend bool operator==(const BigUint& a, const BigUint& b) = default;
+  friend std::strong_ordering operator<=>(const BigUint& a, const BigUint& b);
+
+ private:
+  void trim();
+
+  std::vector<uint64_t> limbs_;
+};
+
+}  // namespace ferric
@@ -0,0 +1,89 @@
+#include "big_int.hh"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <stdexcept>
+
+namespace ferric {
+namespace {
+
+BigUint random_big(std::mt19937_64& rng, size_t limbs) {
+  BigUint value;
+  for (size_t i = 0; i < limbs; ++i) {
+    value <<= 64;
+    value += BigUint(rng() | 1);
+  }
+  return value;
+}
+
+// a * b one limb of b at a time, which only uses the schoolbook kernel
+BigUint slow_multiply(const BigUint& a, const BigUint& b) {
+  BigUint product;
+  const auto limbs = b.limbs();
+  for (size_t i = 0; i < limbs.size(); ++i) {
+    product += (a * BigUint(limbs[i])) << (64 * i);
+  }
+  return product;
+}
+
+TEST(BigUintTest, SmallValues) {
+  EXPECT_TRUE(BigUint().is_zero());
+  EXPECT_TRUE(BigUint(0).is_zero());
+  EXPECT_EQ(BigUint().to_string(), "0");
+  EXPECT_EQ(BigUint(12345).to_string(), "12345");
+  EXPECT_EQ(BigUint(0).bit_width(), 0);
+  EXPECT_EQ(BigUint(1).bit_width(), 1);
+  EXPECT_EQ(BigUint(UINT64_MAX).bit_width(), 64);
+}
+
+TEST(BigUintTest, AddSubtractAndShift) {
+  BigUint x(UINT64_MAX);
+  x += BigUint(1);
+  EXPECT_EQ(x.limbs().size(), 2);
+  EXPECT_EQ(x, BigUint(1) << 64);
+  x -= BigUint(1);
+  EXPECT_EQ(x, BigUint(UINT64_MAX));
+
+  const BigUint big = BigUint(1) << 128;
+  EXPECT_EQ(big.to_string(), "340282366920938463463374607431768211456");
+  EXPECT_EQ(big >> 128, BigUint(1));
+  EXPECT_EQ(big >> 129, BigUint());
+  EXPECT_EQ((big - BigUint(1)).bit_width(), 128);
+  EXPECT_EQ((BigUint(5) << 70) >> 69, BigUint(10));
+
+  EXPECT_THROW(BigUint(3) - BigUint(4), std::invalid_argument);
+  EXPECT_EQ(BigUint(4) - BigUint(4), BigUint());
+}
+
+TEST(BigUintTest, Ordering) {
+  EXPECT_LT(BigUint(3), BigUint(4));
+  EXPECT_LT(BigUint(UINT64_MAX), BigUint(1) << 64);
+  EXPECT_GT((BigUint(2) << 64), (BigUint(1) << 64) + BigUint(UINT64_MAX));
+}
+
+TEST(BigUintTest, MultiplyMatchesSchoolbook) {
+  std::mt19937_64 rng(42);
+  // Sizes straddle the Karatsuba threshold, odd splits and unbalanced operands
+  for (auto [na, nb] : {std::pair<size_t, size_t>{1, 1}, {31, 31}, {32, 32}, {33, 33}, {64, 64},
+                        {101, 101}, {257, 257}, {300, 40}, {40, 300}, {1000, 33}}) {
+    const BigUint a = random_big(rng, na);
+    const BigUint b = random_big(rng, nb);
+    EXPECT_EQ(a * b, slow_multiply(a, b)) << na << " x " << nb;
+  }
+}
+
+TEST(BigUintTest, SquareMatchesMultiply) {
+  std::mt19937_64 rng(7);
+  for (size_t n : {1, 5, 31, 32, 63, 200, 513}) {
+    const BigUint a = random_big(rng, n);
+    const BigUint copy = a;
+    EXPECT_EQ(a * a, a * copy) << n << " limbs";
+  }
+  // All-ones limbs maximise every carry
+  const BigUint ones = (BigUint(1) << (64 * 100)) - BigUint(1);
+  EXPECT_EQ(ones * ones, slow_multiply(ones, ones));
+}
+
+}  // namespace
+}  // namespace ferric
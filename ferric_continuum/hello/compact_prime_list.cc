@@ -0,0 +1,267 @@
+#include "compact_prime_list.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace ferric {
+
+namespace {
+
+constexpr char kMagic[8] = {'F', 'C', 'P', 'L', 'I', 'S', 'T', '\0'};
+constexpr uint32_t kFormatVersion = 1;
+
+// Fixed little-endian layout; followed by num_index IndexEntry records
+// (value, offset as uint64_t) and then gap_bytes varint bytes
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;  // Bit 0: the list starts with 2
+  uint64_t stride;
+  uint64_t odd_count;
+  uint64_t last;
+  uint64_t num_index;
+  uint64_t gap_bytes;
+};
+static_assert(sizeof(Header) == 56);
+
+constexpr uint32_t kHasTwo = 1;
+
+void put_varint(uint64_t v, std::vector<uint8_t>& out) {
+  while (v >= 0x80) {
+    out.push_back(static_cast<uint8_t>(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(v));
+}
+
+// Caller guarantees a complete varint starts at pos
+uint64_t get_varint(const uint8_t* data, size_t& pos) {
+  uint64_t v = data[pos++];
+  if (v < 0x80) {
+    return v;  // The typical half-gap takes this path
+  }
+  v &= 0x7f;
+  for (int shift = 7;; shift += 7) {
+    const uint64_t byte = data[pos++];
+    v |= (byte & 0x7f) << shift;
+    if (byte < 0x80) {
+      return v;
+    }
+  }
+}
+
+}  // namespace
+
+CompactPrimeList::CompactPrimeList(size_t stride) : stride_(stride) {
+  if (stride == 0) {
+    throw std::invalid_argument("CompactPrimeList: stride must be positive");
+  }
+}
+
+CompactPrimeList::CompactPrimeList(std::span<const uint64_t> primes, size_t stride)
+    : CompactPrimeList(stride) {
+  // Gaps of large primes average log(p), one byte each
+  gaps_.reserve(primes.size());
+  index_.reserve(primes.size() / stride + 1);
+  for (const uint64_t p : primes) {
+    push_back(p);
+  }
+}
+
+void CompactPrimeList::push_back(uint64_t p) {
+  if (p == 2 && empty()) {
+    has_two_ = true;
+    return;
+  }
+  if (p % 2 == 0 || (odd_count_ > 0 && p <= last_)) {
+    throw std::invalid_argument(
+        "CompactPrimeList::push_back: entries must be odd and strictly increasing after a "
+        "leading 2");
+  }
+  if (odd_count_ > 0) {
+    put_varint((p - last_) / 2, gaps_);
+  }
+  if (odd_count_ % stride_ == 0) {
+    index_.push_back({p, gaps_.size()});
+  }
+  last_ = p;
+  ++odd_count_;
+}
+
+size_t CompactPrimeList::encoded_bytes() const {
+  return gaps_.size() + index_.size() * sizeof(IndexEntry);
+}
+
+uint64_t CompactPrimeList::seek(size_t k, size_t& pos) const {
+  const IndexEntry& entry = index_[k / stride_];
+  uint64_t value = entry.value;
+  pos = entry.offset;
+  for (size_t steps = k % stride_; steps > 0; --steps) {
+    value += 2 * get_varint(gaps_.data(), pos);
+  }
+  return value;
+}
+
+uint64_t CompactPrimeList::at(size_t i) const {
+  if (i >= size()) {
+    throw std::out_of_range("CompactPrimeList::at: index is past the end");
+  }
+  if (has_two_) {
+    if (i == 0) {
+      return 2;
+    }
+    --i;
+  }
+  size_t pos;
+  return seek(i, pos);
+}
+
+uint64_t CompactPrimeList::back() const {
+  if (empty()) {
+    throw std::out_of_range("CompactPrimeList::back: list is empty");
+  }
+  return odd_count_ > 0 ? last_ : 2;
+}
+
+void CompactPrimeList::decode(size_t first, std::span<uint64_t> out) const {
+  if (first > size() || out.size() > size() - first) {
+    throw std::out_of_range("CompactPrimeList::decode: range is past the end");
+  }
+  size_t i = 0;
+  if (has_two_ && first == 0 && !out.empty()) {
+    out[i++] = 2;
+  }
+  if (i == out.size()) {
+    return;
+  }
+  // Seek once, then every further entry is one varint
+  size_t pos;
+  uint64_t value = seek(first + i - has_two_, pos);
+  out[i++] = value;
+  for (; i < out.size(); ++i) {
+    value += 2 * get_varint(gaps_.data(), pos);
+    out[i] = value;
+  }
+}
+
+std::vector<uint64_t> CompactPrimeList::decode() const {
+  std::vector<uint64_t> primes(size());
+  decode(0, primes);
+  return primes;
+}
+
+std::string CompactPrimeList::serialize() const {
+  if constexpr (std::endian::native != std::endian::little) {
+    throw std::runtime_error("CompactPrimeList::serialize: the format is little-endian only");
+  }
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kFormatVersion;
+  header.flags = has_two_ ? kHasTwo : 0;
+  header.stride = stride_;
+  header.odd_count = odd_count_;
+  header.last = last_;
+  header.num_index = index_.size();
+  header.gap_bytes = gaps_.size();
+
+  std::string bytes(sizeof(Header) + index_.size() * sizeof(IndexEntry) + gaps_.size(), '\0');
+  char* out = bytes.data();
+  std::memcpy(out, &header, sizeof(header));
+  out += sizeof(header);
+  if (!index_.empty()) {
+    std::memcpy(out, index_.data(), index_.size() * sizeof(IndexEntry));
+    out += index_.size() * sizeof(IndexEntry);
+  }
+  if (!gaps_.empty()) {
+    std::memcpy(out, gaps_.data(), gaps_.size());
+  }
+  return bytes;
+}
+
+CompactPrimeList CompactPrimeList::deserialize(std::string_view bytes) {
+  if constexpr (std::endian::native != std::endian::little) {
+    throw std::runtime_error("CompactPrimeList::deserialize: the format is little-endian only");
+  }
+  auto fail = [](const char* why) {
+    throw std::runtime_error(std::string("CompactPrimeList::deserialize: ") + why);
+  };
+  Header header;
+  if (bytes.size() < sizeof(header)) {
+    fail("too short for a header");
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    fail("not a compact prime list");
+  }
+  if (header.version != kFormatVersion || (header.flags & ~kHasTwo) != 0) {
+    fail("unsupported format version");
+  }
+  if (header.stride == 0) {
+    fail("stride must be positive");
+  }
+  const uint64_t expected_index = header.odd_count / header.stride +
+                                  (header.odd_count % header.stride != 0);
+  const uint64_t body = bytes.size() - sizeof(header);
+  if (header.num_index != expected_index || header.num_index > body / sizeof(IndexEntry) ||
+      header.gap_bytes != body - header.num_index * sizeof(IndexEntry)) {
+    fail("section sizes do not match the entry count");
+  }
+
+  CompactPrimeList list(header.stride);
+  list.has_two_ = header.flags & kHasTwo;
+  list.odd_count_ = header.odd_count;
+  list.last_ = header.last;
+  list.index_.resize(header.num_index);
+  list.gaps_.resize(header.gap_bytes);
+  const char* in = bytes.data() + sizeof(header);
+  if (!list.index_.empty()) {
+    std::memcpy(list.index_.data(), in, list.index_.size() * sizeof(IndexEntry));
+    in += list.index_.size() * sizeof(IndexEntry);
+  }
+  if (!list.gaps_.empty()) {
+    std::memcpy(list.gaps_.data(), in, list.gaps_.size());
+  }
+
+  // Lookups trust the index, so check it walks the gaps exactly: each block
+  // must start at its recorded offset and end where the next one starts
+  size_t pos = 0;
+  for (size_t j = 0; j < list.index_.size(); ++j) {
+    const IndexEntry& entry = list.index_[j];
+    if (entry.offset != pos || entry.value % 2 == 0 ||
+        (j > 0 && entry.value <= list.index_[j - 1].value)) {
+      fail("skip index does not match the gap bytes");
+    }
+    const uint64_t in_block =
+        std::min<uint64_t>(header.stride, header.odd_count - j * header.stride);
+    uint64_t value = entry.value;
+    // Gaps within the block, plus the one leading into the next block's first entry
+    const uint64_t gaps = in_block - 1 + (j + 1 < list.index_.size());
+    for (uint64_t g = 0; g < gaps; ++g) {
+      // A varint of at most 10 bytes must end inside the gap section
+      size_t end = pos;
+      while (end < list.gaps_.size() && end - pos < 10 && list.gaps_[end] >= 0x80) {
+        ++end;
+      }
+      if (end >= list.gaps_.size() || end - pos >= 10) {
+        fail("truncated gap");
+      }
+      const uint64_t half_gap = get_varint(list.gaps_.data(), pos);
+      if (half_gap == 0 || half_gap > (std::numeric_limits<uint64_t>::max() - value) / 2) {
+        fail("gap out of range");
+      }
+      value += 2 * half_gap;
+    }
+    if (j + 1 < list.index_.size() ? value != list.index_[j + 1].value : value != list.last_) {
+      fail("skip index does not match the gap bytes");
+    }
+  }
+  if (pos != list.gaps_.size() || (list.odd_count_ == 0 && list.last_ != 0)) {
+    fail("trailing bytes after the last gap");
+  }
+  return list;
+}
+
+}  // namespace ferric
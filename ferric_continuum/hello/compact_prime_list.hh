@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ferric {
+
+// Prime list stored as gaps, at about one byte per prime instead of eight.
+//
+// Every odd prime is stored as half the gap to its predecessor, as an LEB128
+// varint. The typical half-gap is below 128 and takes one byte; the first
+// that needs two follows 436273009 (gap 282), and two bytes are always
+// enough below 2^64, where no gap exceeds 1550. A leading 2 is kept as a
+// flag. A skip index records the value and byte offset of every stride-th
+// odd entry, so at(i) decodes at most stride - 1 varints rather than the
+// whole list.
+//
+// Holds any strictly increasing list of odd numbers, optionally preceded by
+// 2, so subranges such as primes_in_range(lo, hi) encode just as well.
+class CompactPrimeList {
+ public:
+  static constexpr size_t kDefaultStride = 128;
+
+  // An empty list; append with push_back
+  explicit CompactPrimeList(size_t stride = kDefaultStride);
+
+  // Encode primes, which must be strictly increasing and odd apart from a
+  // leading 2. Throws std::invalid_argument otherwise.
+  explicit CompactPrimeList(std::span<const uint64_t> primes, size_t stride = kDefaultStride);
+
+  // Append p, which must be larger than back() and odd unless it is the first
+  // entry and equals 2. Throws std::invalid_argument otherwise.
+  void push_back(uint64_t p);
+
+  size_t size() const { return has_two_ + odd_count_; }
+  bool empty() const { return size() == 0; }
+
+  // Encoded size: gap bytes plus the skip index
+  size_t encoded_bytes() const;
+
+  // The i-th entry (0-based); throws std::out_of_range if i >= size()
+  uint64_t at(size_t i) const;
+  uint64_t back() const;
+
+  // Entries [first, first + out.size()) into out, seeking once and then
+  // decoding sequentially. Throws std::out_of_range past the end.
+  void decode(size_t first, std::span<uint64_t> out) const;
+
+  // Every entry
+  std::vector<uint64_t> decode() const;
+
+  // Self-describing little-endian byte image: a header, the skip index and the
+  // gap bytes
+  std::string serialize() const;
+
+  // Parse serialize() output. Throws std::runtime_error if the bytes are not a
+  // well-formed list.
+  static CompactPrimeList deserialize(std::string_view bytes);
+
+ private:
+  struct IndexEntry {
+    uint64_t value;   // Odd entry number j * stride_
+    uint64_t offset;  // Byte offset of the gap of the entry after it
+  };
+
+  // Odd entry k, walking forward from the nearest index entry; pos is left at
+  // the gap of the entry after it
+  uint64_t seek(size_t k, size_t& pos) const;
+
+  size_t stride_;
+  bool has_two_ = false;
+  size_t odd_count_ = 0;
+  uint64_t last_ = 0;  // Largest odd entry
+  std::vector<IndexEntry> index_;
+  std::vector<uint8_t> gaps_;
+};
+
+}  // namespace ferric
@@ -0,0 +1,105 @@
+#include "compact_prime_list.hh"
+
+#include "prime_sieve.hh"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+std::vector<uint64_t> reference_primes(uint64_t lo, uint64_t hi) {
+  std::vector<uint64_t> primes;
+  for (uint64_t p : PrimeRange(lo, hi)) {
+    primes.push_back(p);
+  }
+  return primes;
+}
+
+TEST(CompactPrimeListTest, RoundTrip) {
+  const auto primes = reference_primes(0, 10000000);
+  const CompactPrimeList list(primes);
+  ASSERT_EQ(list.size(), primes.size());
+  EXPECT_EQ(list.decode(), primes);
+  EXPECT_EQ(list.back(), primes.back());
+  // One byte per prime plus 16 index bytes per 128 primes
+  EXPECT_LT(list.encoded_bytes(), primes.size() * 6 / 5);
+
+  for (size_t i = 0; i < primes.size(); i += 9973) {
+    EXPECT_EQ(list.at(i), primes[i]) << i;
+  }
+  EXPECT_EQ(list.at(primes.size() - 1), primes.back());
+  EXPECT_THROW(list.at(primes.size()), std::out_of_range);
+}
+
+TEST(CompactPrimeListTest, DecodeRuns) {
+  const auto primes = reference_primes(0, 100000);
+  const CompactPrimeList list(primes, 16);
+  // Runs starting on and off index entries, including the leading 2
+  for (const size_t first : {0, 1, 15, 16, 17, 500}) {
+    std::vector<uint64_t> run(40);
+    list.decode(first, run);
+    EXPECT_EQ(run, std::vector<uint64_t>(primes.begin() + first, primes.begin() + first + 40))
+        << first;
+  }
+  std::vector<uint64_t> tail(3);
+  list.decode(primes.size() - 3, tail);
+  EXPECT_EQ(tail.back(), primes.back());
+  EXPECT_THROW(list.decode(primes.size() - 2, tail), std::out_of_range);
+}
+
+TEST(CompactPrimeListTest, WindowsAndWideGaps) {
+  // No leading 2, then values up to 2^64 with two-byte half-gaps
+  const auto window = reference_primes(1000000000000, 1000000100000);
+  CompactPrimeList list(window, 7);
+  EXPECT_EQ(list.decode(), window);
+
+  CompactPrimeList sparse;
+  const std::vector<uint64_t> values = {3, 1001, 1000001, 18446744073709551557ULL};
+  for (const uint64_t v : values) {
+    sparse.push_back(v);
+  }
+  EXPECT_EQ(sparse.decode(), values);
+  EXPECT_EQ(sparse.at(3), 18446744073709551557ULL);
+}
+
+TEST(CompactPrimeListTest, RejectsInvalidEntries) {
+  CompactPrimeList list;
+  EXPECT_TRUE(list.empty());
+  EXPECT_THROW(list.back(), std::out_of_range);
+  list.push_back(2);
+  EXPECT_EQ(list.back(), 2);
+  list.push_back(3);
+  EXPECT_THROW(list.push_back(3), std::invalid_argument);
+  EXPECT_THROW(list.push_back(2), std::invalid_argument);
+  EXPECT_THROW(list.push_back(10), std::invalid_argument);
+  EXPECT_THROW(CompactPrimeList(0), std::invalid_argument);
+}
+
+TEST(CompactPrimeListTest, Serialize) {
+  const auto primes = reference_primes(0, 1000000);
+  const CompactPrimeList list(primes, 64);
+  const std::string bytes = list.serialize();
+  const CompactPrimeList restored = CompactPrimeList::deserialize(bytes);
+  EXPECT_EQ(restored.decode(), primes);
+  EXPECT_EQ(restored.at(12345), primes[12345]);
+
+  EXPECT_EQ(CompactPrimeList::deserialize(CompactPrimeList().serialize()).size(), 0);
+
+  EXPECT_THROW(CompactPrimeList::deserialize(bytes.substr(0, 20)), std::runtime_error);
+  EXPECT_THROW(CompactPrimeList::deserialize(bytes.substr(0, bytes.size() - 1)),
+               std::runtime_error);
+  std::string bad_magic = bytes;
+  bad_magic[0] = 'X';
+  EXPECT_THROW(CompactPrimeList::deserialize(bad_magic), std::runtime_error);
+  // A corrupted gap no longer leads to the next index entry
+  std::string bad_gap = bytes;
+  bad_gap[bytes.size() - 100] ^= 0x01;
+  EXPECT_THROW(CompactPrimeList::deserialize(bad_gap), std::runtime_error);
+}
+
+}  // namespace
+}  // namespace ferric
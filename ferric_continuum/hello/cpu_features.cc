@@ -0,0 +1,24 @@
+#include "cpu_features.hh"
+
+namespace ferric {
+
+namespace {
+
+CpuFeatures detect_cpu_features() {
+  CpuFeatures features;
+#ifdef FERRIC_HAVE_X86_SIMD
+  __builtin_cpu_init();
+  features.avx2 = __builtin_cpu_supports("avx2");
+  features.avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+#endif
+  return features;
+}
+
+}  // namespace
+
+const CpuFeatures& cpu_features() {
+  static const CpuFeatures features = detect_cpu_features();
+  return features;
+}
+
+}  // namespace ferric
@@ -0,0 +1,20 @@
+#pragma once
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#  define FERRIC_HAVE_X86_SIMD 1
+#  include <immintrin.h>
+#endif
+
+namespace ferric {
+
+// Instruction-set extensions of the running CPU, detected once. Kernels built
+// with __attribute__((target(...))) check these before they are called; off
+// x86-64 (FERRIC_HAVE_X86_SIMD undefined) everything reads false.
+struct CpuFeatures {
+  bool avx2 = false;
+  bool avx512 = false;  // AVX-512 F and DQ
+};
+
+const CpuFeatures& cpu_features();
+
+}  // namespace ferric
@@ -0,0 +1,18 @@
+#include "cpu_features.hh"
+
+#include <gtest/gtest.h>
+
+namespace ferric {
+namespace {
+
+TEST(CpuFeaturesTest, DetectedOnce) {
+  const CpuFeatures& features = cpu_features();
+  EXPECT_EQ(&features, &cpu_features());
+#ifndef FERRIC_HAVE_X86_SIMD
+  EXPECT_FALSE(features.avx2);
+  EXPECT_FALSE(features.avx512);
+#endif
+}
+
+}  // namespace
+}  // namespace ferric
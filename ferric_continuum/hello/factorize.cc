@@ -0,0 +1,136 @@
+#include "factorize.hh"
+
+#include "montgomery.hh"
+#include "primality.hh"
+#include "thread_pool.hh"
+
+#include <algorithm>
+#include <bit>
+#include <future>
+#include <numeric>
+#include <stdexcept>
+
+namespace ferric {
+
+namespace {
+
+// Trial division removes every prime factor below this bound
+constexpr uint64_t kTrialBound = 1024;
+
+// Odd trial divisors, tested and divided out by multiplication (see TrialDivisor)
+constexpr auto kTrialDivisors = make_trial_divisors<kTrialBound>();
+
+// Differences multiplied together between gcds
+constexpr uint64_t kBatch = 128;
+
+// Numbers that survived trial division: below kTrialBound^2 they are prime,
+// above it Miller-Rabin decides
+bool is_prime_cofactor(uint64_t n) {
+  return n < kTrialBound * kTrialBound || miller_rabin(n);
+}
+
+// A nontrivial factor of an odd composite n, by Brent's cycle detection on
+// x -> x^2 + c. Products of |x - y| are accumulated in Montgomery form; since
+// 2^64 is coprime to n, their gcd with n is unchanged by the representation.
+uint64_t brent_factor(uint64_t n) {
+  const Montgomery64 mont(n);
+  for (uint64_t c = 1;; ++c) {
+    const uint64_t cm = mont.to_montgomery(c);
+    const auto step = [&](uint64_t v) { return mont.add(mont.mul(v, v), cm); };
+    uint64_t y = mont.to_montgomery(2);
+    uint64_t x = y;
+    uint64_t saved = y;  // y at the start of the last batch, for backtracking
+    uint64_t q = mont.one();
+    uint64_t g = 1;
+    for (uint64_t r = 1; g == 1; r *= 2) {
+      x = y;
+      for (uint64_t i = 0; i < r; ++i) {
+        y = step(y);
+      }
+      for (uint64_t k = 0; k < r && g == 1; k += kBatch) {
+        saved = y;
+        for (uint64_t i = 0; i < std::min(kBatch, r - k); ++i) {
+          y = step(y);
+          q = mont.mul(q, x > y ? x - y : y - x);
+        }
+        g = std::gcd(q, n);
+      }
+    }
+    if (g == n) {
+      // The batch overshot, or q hit 0: redo it one gcd at a time
+      do {
+        saved = step(saved);
+        g = std::gcd(x > saved ? x - saved : saved - x, n);
+      } while (g == 1);
+    }
+    if (g != n) {
+      return g;
+    }
+  }
+}
+
+// Append the prime factors of n, which has no factor below kTrialBound
+void split(uint64_t n, std::vector<uint64_t>& factors) {
+  if (n == 1) {
+    return;
+  }
+  if (is_prime_cofactor(n)) {
+    factors.push_back(n);
+    return;
+  }
+  const uint64_t d = brent_factor(n);
+  split(d, factors);
+  split(n / d, factors);
+}
+
+}  // namespace
+
+std::vector<uint64_t> factorize(uint64_t n) {
+  if (n == 0) {
+    throw std::invalid_argument("factorize: n must be positive");
+  }
+  std::vector<uint64_t> factors;
+  const int twos = std::countr_zero(n);
+  factors.insert(factors.end(), twos, uint64_t{2});
+  n >>= twos;
+  for (const TrialDivisor& d : kTrialDivisors) {
+    if (d.p * d.p > n) {
+      break;
+    }
+    while (d.divides(n)) {
+      factors.push_back(d.p);
+      n = d.exact_quotient(n);
+    }
+  }
+  const size_t trial_count = factors.size();
+  split(n, factors);
+  std::sort(factors.begin() + trial_count, factors.end());
+  return factors;
+}
+
+std::vector<std::vector<uint64_t>> factorize_batch(std::span<const uint64_t> ns,
+                                                   size_t num_threads) {
+  std::vector<std::vector<uint64_t>> results(ns.size());
+  if (num_threads == 1 || ns.size() < 2) {
+    for (size_t i = 0; i < ns.size(); ++i) {
+      results[i] = factorize(ns[i]);
+    }
+    return results;
+  }
+  ThreadPool pool(num_threads);
+  // Interleaved so that slow numbers clustered in the input spread across workers
+  const size_t workers = std::min(pool.size(), ns.size());
+  std::vector<std::future<void>> done;
+  done.reserve(workers);
+  for (size_t w = 0; w < workers; ++w) {
+    done.push_back(pool.submit([&, w] {
+      for (size_t i = w; i < ns.size(); i += workers) {
+        results[i] = factorize(ns[i]);
+      }
+    }));
+  }
+  wait_all(done);
+  return results;
+}
+
+}  // namespace ferric
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace ferric {
+
+// Prime factors of n with multiplicity, in increasing order (empty for 1).
+//
+// Factors below 1024 are removed by trial division. Whatever remains is
+// confirmed prime by deterministic Miller-Rabin or split by Brent's variant of
+// Pollard's rho in Montgomery form, which batches 128 differences into one
+// gcd. Balanced semiprimes near 2^62 take under a millisecond.
+// Throws std::invalid_argument for n == 0.
+std::vector<uint64_t> factorize(uint64_t n);
+
+// factorize(ns[i]) for every i, spread over num_threads workers (0 = one per
+// hardware thread)
+std::vector<std::vector<uint64_t>> factorize_batch(std::span<const uint64_t> ns,
+                                                   size_t num_threads = 0);
+
+}  // namespace ferric
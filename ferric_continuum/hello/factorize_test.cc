@@ -0,0 +1,81 @@
+#include "factorize.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+uint64_t product(const std::vector<uint64_t>& factors) {
+  uint64_t n = 1;
+  for (const uint64_t f : factors) {
+    n *= f;
+  }
+  return n;
+}
+
+bool is_prime_naive(uint64_t n) {
+  if (n < 2) {
+    return false;
+  }
+  for (uint64_t d = 2; d * d <= n; ++d) {
+    if (n % d == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(FactorizeTest, SmallNumbers) {
+  EXPECT_TRUE(factorize(1).empty());
+  EXPECT_EQ(factorize(2), std::vector<uint64_t>({2}));
+  EXPECT_EQ(factorize(360), std::vector<uint64_t>({2, 2, 2, 3, 3, 5}));
+  for (uint64_t n = 1; n < 20000; ++n) {
+    const auto factors = factorize(n);
+    ASSERT_EQ(product(factors), n);
+    ASSERT_TRUE(std::is_sorted(factors.begin(), factors.end())) << n;
+    for (const uint64_t f : factors) {
+      ASSERT_TRUE(is_prime_naive(f)) << n;
+    }
+  }
+  EXPECT_THROW(factorize(0), std::invalid_argument);
+}
+
+TEST(FactorizeTest, LargeNumbers) {
+  // Semiprimes near 2^62 and 2^64, a prime square, and 2^64 - 1
+  EXPECT_EQ(factorize(4611686001247518511ULL),
+            std::vector<uint64_t>({2147483629ULL, 2147483659ULL}));
+  EXPECT_EQ(factorize(18446743979220271189ULL),
+            std::vector<uint64_t>({4294967279ULL, 4294967291ULL}));
+  EXPECT_EQ(factorize(4611686014132420609ULL), std::vector<uint64_t>({2147483647, 2147483647}));
+  EXPECT_EQ(factorize(18446744073709551615ULL),
+            std::vector<uint64_t>({3, 5, 17, 257, 641, 65537, 6700417}));
+  EXPECT_EQ(factorize(18446744073709551557ULL), std::vector<uint64_t>({18446744073709551557ULL}));
+  // Small factors mixed with a large cofactor
+  EXPECT_EQ(factorize(1000003ULL * 1000033 * 1000037 * 4),
+            std::vector<uint64_t>({2, 2, 1000003, 1000033, 1000037}));
+}
+
+TEST(FactorizeTest, Batch) {
+  std::vector<uint64_t> ns;
+  for (uint64_t n = 4611686018427387904ULL; ns.size() < 200; n += 12345) {
+    ns.push_back(n);
+  }
+  for (const size_t threads : {1, 3}) {
+    const auto results = factorize_batch(ns, threads);
+    ASSERT_EQ(results.size(), ns.size());
+    for (size_t i = 0; i < ns.size(); ++i) {
+      EXPECT_EQ(results[i], factorize(ns[i])) << ns[i];
+      EXPECT_EQ(product(results[i]), ns[i]);
+    }
+  }
+  EXPECT_TRUE(factorize_batch({}).empty());
+  const std::vector<uint64_t> with_zero = {6, 0, 10};
+  EXPECT_THROW(factorize_batch(with_zero, 2), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace ferric
@@ -0,0 +1,202 @@
+#include "fibonacci_mod.hh"
+
+#include "factorize.hh"
+#include "montgomery.hh"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ferric {
+
+namespace {
+
+using u128 = unsigned __int128;
+
+// F(n) and F(n + 1), reduced
+struct FibonacciPair {
+  uint64_t f0;
+  uint64_t f1;
+};
+
+int bit_width(u128 n) {
+  const uint64_t high = static_cast<uint64_t>(n >> 64);
+  return high ? 64 + std::bit_width(high) : std::bit_width(static_cast<uint64_t>(n));
+}
+
+// Fast doubling: F(2k) = F(k) (2 F(k+1) - F(k)), F(2k+1) = F(k)^2 + F(k+1)^2
+FibonacciPair pair_mod_odd(u128 n, const Montgomery64& mont) {
+  uint64_t a = 0, b = mont.one();  // F(k), F(k+1) in Montgomery form
+  for (int bit = bit_width(n) - 1; bit >= 0; --bit) {
+    const uint64_t even = mont.mul(a, mont.sub(mont.add(b, b), a));
+    const uint64_t odd = mont.add(mont.mul(a, a), mont.mul(b, b));
+    if (n >> bit & 1) {
+      a = odd;
+      b = mont.add(even, odd);
+    } else {
+      a = even;
+      b = odd;
+    }
+  }
+  return {mont.from_montgomery(a), mont.from_montgomery(b)};
+}
+
+// The same doubling mod 2^64, where uint64_t arithmetic reduces for free
+FibonacciPair pair_mod_2_64(u128 n) {
+  uint64_t a = 0, b = 1;
+  for (int bit = bit_width(n) - 1; bit >= 0; --bit) {
+    const uint64_t even = a * (2 * b - a);
+    const uint64_t odd = a * a + b * b;
+    if (n >> bit & 1) {
+      a = odd;
+      b = even + odd;
+    } else {
+      a = even;
+      b = odd;
+    }
+  }
+  return {a, b};
+}
+
+// F(n) and F(n + 1) mod m for any m >= 1, with m = 2^s q and q odd
+FibonacciPair fibonacci_pair_mod(u128 n, uint64_t m) {
+  const int s = std::countr_zero(m);
+  const uint64_t q = m >> s;
+  const FibonacciPair odd = q > 1 ? pair_mod_odd(n, Montgomery64(q)) : FibonacciPair{0, 0};
+  if (s == 0) {
+    return odd;
+  }
+  const uint64_t mask = (uint64_t{1} << s) - 1;
+  const FibonacciPair low = pair_mod_2_64(n);
+  // x = a + q t with t = (b - a) q^-1 mod 2^s is the residue below m that
+  // agrees with a mod q and with b mod 2^s
+  const uint64_t q_inv = inverse_mod_2_64(q);
+  const auto crt = [&](uint64_t a, uint64_t b) { return a + q * (((b - a) * q_inv) & mask); };
+  return {crt(odd.f0, low.f0), crt(odd.f1, low.f1)};
+}
+
+// Whether the Pisano period of m divides t
+bool is_period(u128 t, uint64_t m) {
+  const FibonacciPair pair = fibonacci_pair_mod(t, m);
+  return pair.f0 == 0 && pair.f1 == 1 % m;
+}
+
+u128 gcd(u128 a, u128 b) {
+  while (b) {
+    a = std::exchange(b, a % b);
+  }
+  return a;
+}
+
+// Period of F(n) mod p^k, starting from a multiple of it: pi(p) divides p - 1
+// when p = +-1 mod 10 and 2 (p + 1) when p = +-3 mod 10, and pi(p^k) divides
+// p^(k-1) pi(p). Any prime factor whose removal still leaves a period is
+// stripped, which lands on the exact period.
+u128 prime_power_period(uint64_t p, int k, uint64_t power) {
+  u128 period;
+  std::vector<uint64_t> factors;
+  if (p == 2) {
+    period = 3;
+    factors = {3};
+  } else if (p == 5) {
+    period = 20;
+    factors = {2, 5};
+  } else if (p % 10 == 1 || p % 10 == 9) {
+    period = p - 1;
+    factors = factorize(p - 1);
+  } else {
+    period = static_cast<u128>(p + 1) * 2;
+    factors = factorize(p + 1);
+    factors.push_back(2);
+  }
+  for (int i = 1; i < k; ++i) {
+    period *= p;
+  }
+  if (k > 1) {
+    factors.push_back(p);
+  }
+  std::sort(factors.begin(), factors.end());
+  factors.erase(std::unique(factors.begin(), factors.end()), factors.end());
+  for (const uint64_t q : factors) {
+    while (period % q == 0 && is_period(period / q, power)) {
+      period /= q;
+    }
+  }
+  return period;
+}
+
+// The period of m is the lcm of the periods of its prime powers
+u128 pisano_period_wide(uint64_t m) {
+  if (m == 0) {
+    throw std::invalid_argument("pisano_period: modulus must be positive");
+  }
+  const std::vector<uint64_t> factors = factorize(m);
+  u128 period = 1;
+  for (size_t i = 0; i < factors.size();) {
+    const uint64_t p = factors[i];
+    int k = 0;
+    uint64_t power = 1;
+    for (; i < factors.size() && factors[i] == p; ++i) {
+      ++k;
+      power *= p;
+    }
+    const u128 part = prime_power_period(p, k, power);
+    period = period / gcd(period, part) * part;
+  }
+  return period;
+}
+
+}  // namespace
+
+uint64_t fibonacci_mod(uint64_t n, uint64_t m) {
+  if (m == 0) {
+    throw std::invalid_argument("fibonacci_mod: modulus must be positive");
+  }
+  return fibonacci_pair_mod(n, m).f0;
+}
+
+uint64_t pisano_period(uint64_t m) {
+  const u128 period = pisano_period_wide(m);
+  if (period > std::numeric_limits<uint64_t>::max()) {
+    throw std::out_of_range("pisano_period: period does not fit in uint64_t");
+  }
+  return static_cast<uint64_t>(period);
+}
+
+unsigned __int128 PisanoCache::lookup(uint64_t m) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = periods_.find(m);
+    if (it != periods_.end()) {
+      return it->second;
+    }
+  }
+  // Factor outside the lock so a slow modulus does not stall other lookups
+  const u128 period = pisano_period_wide(m);
+  std::lock_guard<std::mutex> lock(mutex_);
+  periods_.emplace(m, period);
+  return period;
+}
+
+uint64_t PisanoCache::period(uint64_t m) {
+  const u128 period = lookup(m);
+  if (period > std::numeric_limits<uint64_t>::max()) {
+    throw std::out_of_range("PisanoCache: period does not fit in uint64_t");
+  }
+  return static_cast<uint64_t>(period);
+}
+
+uint64_t PisanoCache::fibonacci_mod(uint64_t n, uint64_t m) {
+  const u128 period = lookup(m);
+  return ferric::fibonacci_mod(static_cast<uint64_t>(n % period), m);
+}
+
+size_t PisanoCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return periods_.size();
+}
+
+}  // namespace ferric
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "absl/container/flat_hash_map.h"
+
+#include <cstdint>
+#include <mutex>
+
+namespace ferric {
+
+// F(n) mod m by fast doubling, O(log n) modular products and no hardware
+// division. The odd part of m is handled in Montgomery form, a power-of-two
+// part with plain wrapping arithmetic, and the two residues are joined by the
+// Chinese remainder theorem. Throws std::invalid_argument if m == 0.
+uint64_t fibonacci_mod(uint64_t n, uint64_t m);
+
+// Pisano period of m: the period of the sequence F(n) mod m. Found by factoring
+// m, taking the known multiple of each prime power's period and stripping
+// prime factors while it stays a period. Throws std::invalid_argument if
+// m == 0 and std::out_of_range if the period does not fit in uint64_t (only
+// possible for m above 2^64 / 6).
+uint64_t pisano_period(uint64_t m);
+
+// Thread-safe cache of Pisano periods, for workloads that keep querying the
+// same moduli with huge n: once the period of m is known, fibonacci_mod(n, m)
+// only needs fast doubling over n mod period.
+class PisanoCache {
+ public:
+  PisanoCache() = default;
+
+  PisanoCache(const PisanoCache&) = delete;
+  PisanoCache& operator=(const PisanoCache&) = delete;
+
+  // pisano_period(m), computed on first use
+  uint64_t period(uint64_t m);
+
+  // Same result as the free fibonacci_mod, reducing n by the cached period first
+  uint64_t fibonacci_mod(uint64_t n, uint64_t m);
+
+  // Number of moduli whose period is cached
+  size_t size() const;
+
+ private:
+  unsigned __int128 lookup(uint64_t m);
+
+  mutable std::mutex mutex_;
+  absl::flat_hash_map<uint64_t, unsigned __int128> periods_;
+};
+
+}  // namespace ferric
@@ -0,0 +1,103 @@
+#include "fibonacci_mod.hh"
+
+#include "hello_lib.hh"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+// Period of F(n) mod m by walking the sequence until (0, 1) comes back
+uint64_t naive_period(uint64_t m) {
+  uint64_t a = 0, b = 1 % m, n = 0;
+  do {
+    const uint64_t next = (a + b) % m;
+    a = b;
+    b = next;
+    ++n;
+  } while (a != 0 || b != 1 % m);
+  return n;
+}
+
+TEST(FibonacciModTest, MatchesExactValues) {
+  for (uint64_t m : std::vector<uint64_t>{1, 2, 3, 10, 64, 97, 1000000007ULL, 3ULL << 40,
+                     18446744073709551557ULL, 18446744073709551615ULL}) {
+    for (int n = 0; n <= 93; ++n) {
+      ASSERT_EQ(fibonacci_mod(n, m), fibonacci(n) % m) << "n = " << n << ", m = " << m;
+    }
+  }
+}
+
+TEST(FibonacciModTest, HugeIndices) {
+  // Reference values from an independent big-integer implementation
+  EXPECT_EQ(fibonacci_mod(1000000000000000000ULL, 1000000007ULL), 209783453ULL);
+  EXPECT_EQ(fibonacci_mod(1000000000000000000ULL, 18446744073709551615ULL),
+            10068635698145506875ULL);
+  EXPECT_EQ(fibonacci_mod(1000000000000000000ULL, 1ULL << 63), 3919126379787055675ULL);
+  EXPECT_EQ(fibonacci_mod(1000000000000000000ULL, 18446744073709551608ULL),
+            14860018885783810099ULL);
+  EXPECT_EQ(fibonacci_mod(12345678901234567890ULL, 998244353ULL), 291349816ULL);
+  EXPECT_EQ(fibonacci_mod(UINT64_MAX, 1000000000000000000ULL), 19507593362999010ULL);
+  EXPECT_THROW(fibonacci_mod(5, 0), std::invalid_argument);
+}
+
+TEST(FibonacciModTest, PisanoPeriods) {
+  for (uint64_t m = 1; m <= 2000; ++m) {
+    ASSERT_EQ(pisano_period(m), naive_period(m)) << "m = " << m;
+  }
+  // pi(10^k) = 15 * 10^(k-1) for k >= 3
+  EXPECT_EQ(pisano_period(1000), 1500);
+  EXPECT_EQ(pisano_period(1000000000000000000ULL), 1500000000000000000ULL);
+  EXPECT_EQ(pisano_period(1000000007ULL), 2000000016ULL);
+  EXPECT_THROW(pisano_period(0), std::invalid_argument);
+  // Primes = +-3 mod 10 have a period dividing 2 (p + 1), here 2 (p + 1) / 7
+  EXPECT_EQ(pisano_period(18446744073709551557ULL), 5270498306774157588ULL);
+  // ... and here all of 2 (p + 1), past uint64_t
+  EXPECT_THROW(pisano_period(18446744073709551533ULL), std::out_of_range);
+}
+
+TEST(FibonacciModTest, CacheReducesByPeriod) {
+  PisanoCache cache;
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.period(1000000007ULL), 2000000016ULL);
+  EXPECT_EQ(cache.size(), 1);
+  for (uint64_t m : {1000000007ULL, 1000000000000000000ULL, 18446744073709551557ULL, 7ULL << 50}) {
+    for (uint64_t n : std::vector<uint64_t>{0, 1, 1000000000000000000ULL, UINT64_MAX}) {
+      EXPECT_EQ(cache.fibonacci_mod(n, m), fibonacci_mod(n, m)) << "n = " << n << ", m = " << m;
+    }
+  }
+  EXPECT_EQ(cache.size(), 4);
+  EXPECT_THROW(cache.period(18446744073709551533ULL), std::out_of_range);
+  EXPECT_EQ(cache.fibonacci_mod(UINT64_MAX, 18446744073709551533ULL),
+            fibonacci_mod(UINT64_MAX, 18446744073709551533ULL));
+}
+
+TEST(FibonacciModTest, CacheIsThreadSafe) {
+  PisanoCache cache;
+  std::vector<std::thread> threads;
+  std::vector<int> mismatches(4, 0);
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (uint64_t m = 2; m < 300; ++m) {
+        const uint64_t n = 1000000000000000000ULL + m * (t + 1);
+        if (cache.fibonacci_mod(n, m) != fibonacci_mod(n, m)) {
+          ++mismatches[t];
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < 4; ++t) {
+    EXPECT_EQ(mismatches[t], 0) << "thread " << t;
+  }
+  EXPECT_EQ(cache.size(), 298);
+}
+
+}  // namespace
+}  // namespace ferric
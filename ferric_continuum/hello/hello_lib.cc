@@ -1,59 +1,392 @@
 #include "hello_lib.hh"
 
 #include "absl/strings/str_cat.h"
-#include "absl/strings/str_join.h"
+#include "cpu_features.hh"
+#include "montgomery.hh"
+#include "number_format.hh"
+#include "prime_sieve.hh"
+#include "primality.hh"
+#include "small_prime_filter.hh"
+#include "thread_pool.hh"
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cmath>
+#include <cstring>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
 
 namespace ferric {
 
+namespace {
+
+// Candidates run through Miller-Rabin together; independent Montgomery chains
+// keep the multiplier busy where a single exponentiation would stall on latency
+constexpr size_t kMillerRabinLanes = 4;
+
+// Miller-Rabin rounds for `bases` on kMillerRabinLanes odd n > 2 at once. The
+// lane loops have a fixed trip count and select results instead of branching on
+// exponent bits, so the compiler keeps every lane in registers.
+std::array<bool, kMillerRabinLanes> miller_rabin_lanes(
+    const std::array<uint64_t, kMillerRabinLanes>& n, std::span<const uint64_t> bases) {
+  // Placeholder moduli are overwritten below; Montgomery64 has no default state
+  std::array<Montgomery64, kMillerRabinLanes> mont{Montgomery64(1), Montgomery64(1),
+                                                   Montgomery64(1), Montgomery64(1)};
+  std::array<uint64_t, kMillerRabinLanes> d;
+  std::array<int, kMillerRabinLanes> s;
+  std::array<bool, kMillerRabinLanes> prime;
+  int max_bits = 0;
+  int max_s = 0;
+  for (size_t l = 0; l < kMillerRabinLanes; ++l) {
+    mont[l] = Montgomery64(n[l]);
+    s[l] = std::countr_zero(n[l] - 1);
+    d[l] = (n[l] - 1) >> s[l];
+    max_bits = std::max(max_bits, static_cast<int>(std::bit_width(d[l])));
+    max_s = std::max(max_s, s[l]);
+    prime[l] = true;
+  }
+
+  for (uint64_t base : bases) {
+    // Stop once every lane is known to be composite
+    if (std::none_of(prime.begin(), prime.end(), [](bool p) { return p; })) {
+      break;
+    }
+    std::array<uint64_t, kMillerRabinLanes> x;
+    std::array<uint64_t, kMillerRabinLanes> power;
+    std::array<bool, kMillerRabinLanes> skip;
+    for (size_t l = 0; l < kMillerRabinLanes; ++l) {
+      const uint64_t a = base % n[l];
+      skip[l] = !prime[l] || a == 0;
+      x[l] = mont[l].one();
+      power[l] = mont[l].to_montgomery(a);
+    }
+    // a^d, right to left, one exponent bit per step across all lanes
+    for (int bit = 0; bit < max_bits; ++bit) {
+      for (size_t l = 0; l < kMillerRabinLanes; ++l) {
+        const uint64_t product = mont[l].mul(x[l], power[l]);
+        x[l] = (d[l] >> bit & 1) ? product : x[l];
+        power[l] = mont[l].mul(power[l], power[l]);
+      }
+    }
+    std::array<bool, kMillerRabinLanes> pending;
+    for (size_t l = 0; l < kMillerRabinLanes; ++l) {
+      pending[l] = !skip[l] && x[l] != mont[l].one() && x[l] != mont[l].minus_one();
+    }
+    // Square until n - 1 appears; lanes that never reach it are composite
+    for (int r = 1; r < max_s; ++r) {
+      for (size_t l = 0; l < kMillerRabinLanes; ++l) {
+        x[l] = mont[l].mul(x[l], x[l]);
+        pending[l] = pending[l] && (r >= s[l] || x[l] != mont[l].minus_one());
+      }
+    }
+    for (size_t l = 0; l < kMillerRabinLanes; ++l) {
+      prime[l] = prime[l] && !pending[l];
+    }
+  }
+  return prime;
+}
+
+// Integers below 2^53 convert to double exactly
+constexpr uint64_t kExactDoubleLimit = uint64_t{1} << 53;
+
+// primes_up_to gives back reserved capacity beyond 1/64 of its result
+constexpr size_t kMaxReserveSlack = 64;
+
+// Sieve [lo, hi) on the pool. Each chunk fills its own vector from a shared,
+// read-only sieving-prime table; the vectors are then copied into place in
+// parallel, so no worker ever takes a lock on the hot path.
+std::vector<uint64_t> collect_primes_parallel(uint64_t lo, uint64_t hi, ThreadPool& pool) {
+  const auto [chunks, primes] = plan_parallel_sieve(lo, hi, pool.size());
+
+  std::vector<std::vector<uint64_t>> parts(chunks.size());
+  std::vector<std::future<void>> done;
+  done.reserve(chunks.size());
+  for (size_t c = 0; c < chunks.size(); ++c) {
+    done.push_back(pool.submit([&, c] {
+      SegmentedSieve sieve(chunks[c].first, chunks[c].second, primes);
+      while (sieve.next_segment()) {
+        sieve.for_each_prime([&](uint64_t p) { parts[c].push_back(p); });
+      }
+    }));
+  }
+  wait_all(done);
+
+  std::vector<size_t> offsets(parts.size() + 1, 0);
+  for (size_t c = 0; c < parts.size(); ++c) {
+    offsets[c + 1] = offsets[c] + parts[c].size();
+  }
+  std::vector<uint64_t> result(offsets.back());
+  done.clear();
+  for (size_t c = 0; c < parts.size(); ++c) {
+    done.push_back(pool.submit([&, c] {
+      if (!parts[c].empty()) {
+        std::memcpy(result.data() + offsets[c], parts[c].data(),
+                    parts[c].size() * sizeof(uint64_t));
+      }
+      std::vector<uint64_t>().swap(parts[c]);
+    }));
+  }
+  wait_all(done);
+  return result;
+}
+
+#ifdef FERRIC_HAVE_X86_SIMD
+
+// Eight table lookups per step as two 4-lane gathers. Indices are clamped so
+// every gather stays inside the table, and any clamped lane is reported after
+// the loop. Returns how many leading entries were written; the caller finishes
+// the tail.
+__attribute__((target("avx2"))) size_t fibonacci_batch_avx2(const int* ns, size_t count,
+                                                            uint64_t* out) {
+  const auto* table = reinterpret_cast<const long long*>(kFibonacciTable.data());
+  const __m256i max_n = _mm256_set1_epi32(kMaxFibonacci);
+  __m256i clamped = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    // Negative n reads as a huge unsigned value, so one unsigned min covers both bounds
+    const __m256i n = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ns + i));
+    const __m256i index = _mm256_min_epu32(n, max_n);
+    clamped = _mm256_or_si256(clamped, _mm256_xor_si256(index, n));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_i32gather_epi64(table, _mm256_castsi256_si128(index), 8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 4),
+                        _mm256_i32gather_epi64(table, _mm256_extracti128_si256(index, 1), 8));
+  }
+  if (!_mm256_testz_si256(clamped, clamped)) {
+    throw std::out_of_range("fibonacci: n must be in [0, 93] to fit in uint64_t");
+  }
+  return i;
+}
+
+#endif  // FERRIC_HAVE_X86_SIMD
+
+}  // namespace
+
 std::string generate_greeting(absl::string_view name) {
   // Using Abseil's StrCat for efficient string concatenation
   return absl::StrCat("Hello, ", name, "! Welcome to Ferric Continuum (C++ Edition with Abseil)");
 }
 
-uint64_t fibonacci(int n) {
-  if (n <= 1)
-    return n;
+void fibonacci_batch(std::span<const int> ns, std::span<uint64_t> out) {
+  if (out.size() < ns.size()) {
+    throw std::invalid_argument("fibonacci_batch: out is shorter than ns");
+  }
+  size_t done = 0;
+#ifdef FERRIC_HAVE_X86_SIMD
+  if (cpu_features().avx2) {
+    done = fibonacci_batch_avx2(ns.data(), ns.size(), out.data());
+  }
+#endif
+  for (size_t i = done; i < ns.size(); ++i) {
+    out[i] = fibonacci(ns[i]);
+  }
+}
 
-  uint64_t a = 0, b = 1;
-  for (int i = 2; i <= n; ++i) {
-    uint64_t temp = a + b;
-    a = b;
-    b = temp;
+BigUint fibonacci_big(uint64_t n) {
+  // Walk the bits of n from the top, keeping f = F(k) and l = L(k):
+  //   F(2k) = F(k) L(k),  L(2k) = L(k)^2 - 2 (-1)^k,
+  //   F(2k+1) = (F(2k) + L(2k)) / 2,  L(2k+1) = (5 F(2k) + L(2k)) / 2
+  BigUint f(0), l(2);
+  bool k_odd = false;
+  for (int bit = std::bit_width(n) - 1; bit >= 0; --bit) {
+    const bool set = n >> bit & 1;
+    if (bit == 0 && !set) {
+      return f * l;  // The last step only needs F(2k)
+    }
+    BigUint f2 = f * l;
+    BigUint l2 = l * l;
+    if (k_odd) {
+      l2 += BigUint(2);
+    } else {
+      l2 -= BigUint(2);
+    }
+    if (set) {
+      f = (f2 + l2) >> 1;
+      l = ((f2 << 2) + f2 + l2) >> 1;
+    } else {
+      f = std::move(f2);
+      l = std::move(l2);
+    }
+    k_odd = set;
   }
-  return b;
+  return f;
 }
 
-bool is_prime(uint64_t n) {
-  if (n < 2)
-    return false;
-  if (n == 2)
-    return true;
-  if (n % 2 == 0)
-    return false;
+void is_prime_batch(std::span<const uint64_t> candidates, std::span<uint8_t> results) {
+  if (results.size() < candidates.size()) {
+    throw std::invalid_argument("is_prime_batch: results is shorter than candidates");
+  }
+
+  constexpr size_t kBlock = 256;
+  std::array<SmallPrimeVerdict, kBlock> verdicts;
+  for (size_t start = 0; start < candidates.size(); start += kBlock) {
+    const size_t count = std::min(kBlock, candidates.size() - start);
+    small_prime_filter(candidates.subspan(start, count), verdicts);
 
-  uint64_t limit = static_cast<uint64_t>(std::sqrt(n));
-  for (uint64_t i = 3; i <= limit; i += 2) {
-    if (n % i == 0)
-      return false;
+    // Survivors of the prefilter go through Miller-Rabin kMillerRabinLanes at a
+    // time. Most composites already fail the first base, so that round runs on
+    // its own and only its survivors are grouped again for the remaining bases.
+    std::array<size_t, kBlock> pending;
+    size_t num_pending = 0;
+    for (size_t i = 0; i < count; ++i) {
+      if (verdicts[i] == SmallPrimeVerdict::kUnknown) {
+        pending[num_pending++] = start + i;
+      } else {
+        results[start + i] = verdicts[i] == SmallPrimeVerdict::kPrime;
+      }
+    }
+    const std::span<const uint64_t> bases(kMillerRabinBases);
+    for (std::span<const uint64_t> round : {bases.first(1), bases.subspan(1)}) {
+      size_t survivors = 0;
+      for (size_t g = 0; g < num_pending; g += kMillerRabinLanes) {
+        const size_t lanes = std::min(kMillerRabinLanes, num_pending - g);
+        // A partial group is padded with copies of its first candidate
+        std::array<uint64_t, kMillerRabinLanes> group;
+        for (size_t l = 0; l < kMillerRabinLanes; ++l) {
+          group[l] = candidates[pending[g + (l < lanes ? l : 0)]];
+        }
+        const auto prime = miller_rabin_lanes(group, round);
+        for (size_t l = 0; l < lanes; ++l) {
+          results[pending[g + l]] = prime[l];
+          if (prime[l]) {
+            pending[survivors++] = pending[g + l];
+          }
+        }
+      }
+      num_pending = survivors;
+    }
   }
-  return true;
 }
 
 std::vector<uint64_t> primes_up_to(uint64_t n) {
   std::vector<uint64_t> primes;
-  for (uint64_t i = 2; i <= n; ++i) {
-    if (is_prime(i)) {
-      primes.push_back(i);
-    }
+  primes.reserve(prime_count_upper_bound(n));
+  primes_up_to(n, std::back_inserter(primes));
+  // The bound is loose only for small n, where trimming the slack costs little;
+  // for large n a shrink would copy the whole result to save a fraction of a percent
+  if (primes.capacity() - primes.size() > primes.size() / kMaxReserveSlack) {
+    primes.shrink_to_fit();
   }
   return primes;
 }
 
+size_t primes_up_to(uint64_t n, std::span<uint64_t> out) {
+  if (n < 2) {
+    return 0;
+  }
+  const uint64_t hi = n == std::numeric_limits<uint64_t>::max() ? n : n + 1;
+  SegmentedSieve sieve(2, hi);
+  uint64_t* next = out.data();
+  while (sieve.next_segment()) {
+    // One bounds check per segment; its bitmap is still in L1 for the count
+    if (sieve.count_primes() > static_cast<size_t>(out.data() + out.size() - next)) {
+      throw std::invalid_argument("primes_up_to: output span is too small");
+    }
+    sieve.for_each_prime([&](uint64_t p) { *next++ = p; });
+  }
+  return static_cast<size_t>(next - out.data());
+}
+
+std::vector<uint64_t> primes_up_to(uint64_t n, size_t num_threads) {
+  if (n < 2) {
+    return {};
+  }
+  ThreadPool pool(num_threads);
+  const uint64_t hi = n == std::numeric_limits<uint64_t>::max() ? n : n + 1;
+  return collect_primes_parallel(2, hi, pool);
+}
+
+std::vector<uint64_t> primes_in_range(uint64_t lo, uint64_t hi, size_t num_threads) {
+  if (lo >= hi) {
+    return {};
+  }
+  ThreadPool pool(num_threads);
+  return collect_primes_parallel(lo, hi, pool);
+}
+
+uint64_t prime_count(uint64_t x) {
+  if (x < 2) {
+    return 0;
+  }
+  // Lucy_Hedgehog: S(v) = #{primes <= v} for every v in {x / i}, starting from
+  // "everything >= 2" and removing the multiples of each prime p <= sqrt(x) in
+  // turn. S(v) for v <= r lives in small[v], S(x / i) in large[i].
+  const uint64_t r = isqrt(x);
+  // pi(r) < 2^32, so the small half fits in 32 bits and stays cache-denser
+  std::vector<uint32_t> small(r + 1);
+  std::vector<uint64_t> large(r + 1);
+  for (uint64_t i = 1; i <= r; ++i) {
+    small[i] = static_cast<uint32_t>(i - 1);
+    large[i] = x / i - 1;
+  }
+  for (uint64_t p = 2; p <= r; ++p) {
+    if (small[p] == small[p - 1]) {
+      continue;  // Not prime
+    }
+    const uint32_t below = small[p - 1];  // Primes less than p
+    const uint64_t square = p * p;
+    const uint64_t large_end = std::min(r, x / square);
+    // S(x / i) for i * p <= r reads large[], beyond that small[]
+    const uint64_t direct_end = std::min(large_end, r / p);
+    for (uint64_t i = 1; i <= direct_end; ++i) {
+      large[i] -= large[i * p] - below;
+    }
+    if (x < kExactDoubleLimit) {
+      // A correctly rounded double quotient is exact or one too high, and
+      // costs a fraction of a 64-bit hardware divide
+      const double xd = static_cast<double>(x);
+      for (uint64_t i = direct_end + 1; i <= large_end; ++i) {
+        const uint64_t d = i * p;
+        uint64_t q = static_cast<uint64_t>(xd / static_cast<double>(d));
+        q -= q * d > x;
+        large[i] -= small[q] - below;
+      }
+    } else {
+      for (uint64_t i = direct_end + 1; i <= large_end; ++i) {
+        large[i] -= small[x / (i * p)] - below;
+      }
+    }
+    // Every v in [q * p, q * p + p) shares v / p = q, so walk q instead of dividing.
+    // Descending q reads each small[q] before this round overwrites it.
+    for (uint64_t q = r / p; q >= p; --q) {
+      const uint32_t removed = small[q] - below;
+      const uint64_t end = std::min(r, q * p + p - 1);
+      for (uint64_t v = q * p; v <= end; ++v) {
+        small[v] -= removed;
+      }
+    }
+  }
+  return large[1];
+}
+
+uint64_t prime_count_upper_bound(uint64_t x) {
+  if (x < 2) {
+    return 0;
+  }
+  const double xd = static_cast<double>(x);
+  const double log_x = std::log(xd);
+  // Pierre Dusart, "Estimates of some functions over primes without R.H." (2010),
+  // and Rosser and Schoenfeld (1962) for small x. The margin between either bound
+  // and pi(x) dwarfs the rounding error of the double arithmetic.
+  const double bound = x >= 355991
+                           ? xd / log_x * (1 + 1 / log_x + 2.51 / (log_x * log_x))
+                           : 1.25506 * xd / log_x;
+  return static_cast<uint64_t>(std::ceil(bound));
+}
+
+PrimeRange prime_range(uint64_t lo, uint64_t hi) {
+  return PrimeRange(lo, hi);
+}
+
 std::string format_number_list(const std::vector<uint64_t>& numbers) {
-  // Using Abseil's StrJoin for elegant list formatting
-  return absl::StrJoin(numbers, ", ");
+  // Sized exactly up front, so the string is allocated once and never regrown
+  std::string text(formatted_list_size(numbers), '\0');
+  format_number_list_to(numbers, text);
+  return text;
 }
 
 }  // namespace ferric
@@ -1,7 +1,16 @@
 #pragma once
 
 #include "absl/strings/string_view.h"
+#include "big_int.hh"
+#include "prime_sieve.hh"
+#include "primality.hh"
 
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -10,16 +19,119 @@ namespace ferric {
 // Generate a greeting message using Abseil string utilities
 std::string generate_greeting(absl::string_view name);
 
-// Calculate fibonacci number (demonstrating simple algorithm)
-uint64_t fibonacci(int n);
+// Largest n with F(n) < 2^64
+inline constexpr int kMaxFibonacci = 93;
 
-// Check if a number is prime
-bool is_prime(uint64_t n);
+consteval std::array<uint64_t, kMaxFibonacci + 1> make_fibonacci_table() {
+  std::array<uint64_t, kMaxFibonacci + 1> table{};
+  table[1] = 1;
+  for (int n = 2; n <= kMaxFibonacci; ++n) {
+    table[n] = table[n - 1] + table[n - 2];
+  }
+  return table;
+}
 
-// Get all prime numbers up to n
+// F(0) through F(93), built at compile time
+inline constexpr std::array<uint64_t, kMaxFibonacci + 1> kFibonacciTable = make_fibonacci_table();
+
+// Calculate fibonacci number: a single load from kFibonacciTable, and a
+// compile-time constant for constant n. F(93) is the largest that fits in
+// uint64_t; throws std::out_of_range for n < 0 or n > 93.
+constexpr uint64_t fibonacci(int n) {
+  if (n < 0 || n > kMaxFibonacci) {
+    throw std::out_of_range("fibonacci: n must be in [0, 93] to fit in uint64_t");
+  }
+  return kFibonacciTable[n];
+}
+
+// out[i] = fibonacci(ns[i]) for a whole column of indices. Every n is a
+// lookup in kFibonacciTable, so fast doubling never pays off below F(93);
+// instead the lookups run eight at a time as AVX2 gathers when the CPU has
+// them. Throws std::out_of_range if any n is outside [0, 93], leaving out
+// partly written. out.size() must be at least ns.size().
+void fibonacci_batch(std::span<const int> ns, std::span<uint64_t> out);
+
+// F(n) to full precision, by fast doubling on (F(k), L(k)) with the Lucas
+// numbers L(k): each bit of n costs one product and one square
+BigUint fibonacci_big(uint64_t n);
+
+// Check if a number is prime: one bitmap load below 2^16, otherwise division-free
+// trial division by the primes below 64 (a multiply and a compare each, see
+// TrialDivisor), then deterministic Miller-Rabin with Montgomery multiplication.
+// Exact for every uint64_t, and usable in constant expressions.
+constexpr bool is_prime(uint64_t n) {
+  if (n < kSmallPrimeTableLimit) {
+    return is_small_prime(n);
+  }
+  if (n % 2 == 0) {
+    return false;
+  }
+  for (const TrialDivisor& d : kSmallPrimeDivisors) {
+    if (d.divides(n)) {
+      return false;
+    }
+  }
+  return miller_rabin(n);
+}
+
+// Primality of many candidates at once: results[i] = is_prime(candidates[i]).
+// The small-prime prefilter runs in AVX2/AVX-512 lanes (picked at runtime, scalar
+// fallback) and survivors share interleaved Miller-Rabin exponentiations.
+void is_prime_batch(std::span<const uint64_t> candidates, std::span<uint8_t> results);
+
+// Get all prime numbers up to n (segmented Sieve of Eratosthenes, see prime_sieve.hh).
+// The vector is reserved once from prime_count_upper_bound(n) instead of growing
+// by doubling, so peak memory stays at the size of the result.
 std::vector<uint64_t> primes_up_to(uint64_t n);
 
-// Format a list of numbers as a comma-separated string using Abseil
+// The same primes, written to out in increasing order; returns the end of the output
+template <std::output_iterator<uint64_t> Out>
+Out primes_up_to(uint64_t n, Out out);
+
+// The same primes, written to the front of out; returns how many were written.
+// prime_count_upper_bound(n) entries always suffice. Throws std::invalid_argument
+// if out is too small, leaving it partly written.
+size_t primes_up_to(uint64_t n, std::span<uint64_t> out);
+
+// Same result, sieved on num_threads worker threads (0 = one per hardware thread).
+// Workers share one sieving-prime table and write disjoint output chunks.
+std::vector<uint64_t> primes_up_to(uint64_t n, size_t num_threads);
+
+// All primes in [lo, hi), sieving only that window: the sieving primes go up to
+// sqrt(hi) and the window is split across num_threads workers (0 = one per
+// hardware thread). Serves windows anywhere below 2^64, such as
+// [10^18, 10^18 + 10^9), where primes_up_to would have to start from 2.
+std::vector<uint64_t> primes_in_range(uint64_t lo, uint64_t hi, size_t num_threads = 0);
+
+// Number of primes <= x, without enumerating them (Lucy_Hedgehog:
+// O(x^(3/4)) time, O(sqrt(x)) memory)
+uint64_t prime_count(uint64_t x);
+
+// Upper bound on prime_count(x) in constant time, for sizing outputs: Dusart's
+// x / ln x * (1 + 1 / ln x + 2.51 / ln^2 x) from x = 355991 on, and 1.25506 x / ln x
+// below that. Exceeds pi(x) by at most 0.1% from x = 10^6 on.
+uint64_t prime_count_upper_bound(uint64_t x);
+
+// Primes in [lo, hi), generated lazily one sieve segment at a time. Memory stays
+// O(sqrt(hi)) regardless of the range length, unlike primes_up_to.
+PrimeRange prime_range(uint64_t lo, uint64_t hi);
+
+// Format a list of numbers as a comma-separated string. See number_format.hh
+// for variants that write into a caller's buffer or an absl::Cord.
 std::string format_number_list(const std::vector<uint64_t>& numbers);
 
+template <std::output_iterator<uint64_t> Out>
+Out primes_up_to(uint64_t n, Out out) {
+  if (n < 2) {
+    return out;
+  }
+  // UINT64_MAX itself is composite, so the half-open range can stop just short of it
+  const uint64_t hi = n == std::numeric_limits<uint64_t>::max() ? n : n + 1;
+  SegmentedSieve sieve(2, hi);
+  while (sieve.next_segment()) {
+    sieve.for_each_prime([&](uint64_t p) { *out++ = p; });
+  }
+  return out;
+}
+
 }  // namespace ferric
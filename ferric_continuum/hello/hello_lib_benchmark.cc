@@ -0,0 +1,180 @@
+#include "hello_lib.hh"
+#include "number_format.hh"
+#include "prime_stats.hh"
+#include "prime_writer.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+// Thread counts 1, 2, 4, ... up to the machine, plus the machine itself
+void ThreadCounts(benchmark::internal::Benchmark* b) {
+  const int hardware = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  for (int threads = 1; threads < hardware; threads *= 2) {
+    b->Arg(threads);
+  }
+  b->Arg(hardware);
+}
+
+// Table lookups for a column of indices, one call versus one per row
+void BM_FibonacciBatch(benchmark::State& state) {
+  std::vector<int> ns(state.range(0));
+  for (size_t i = 0; i < ns.size(); ++i) {
+    ns[i] = static_cast<int>(i * 37 % 94);
+  }
+  std::vector<uint64_t> out(ns.size());
+  for (auto _ : state) {
+    fibonacci_batch(ns, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * ns.size());
+}
+BENCHMARK(BM_FibonacciBatch)->Arg(1 << 16);
+
+void BM_FibonacciPerRow(benchmark::State& state) {
+  std::vector<int> ns(state.range(0));
+  for (size_t i = 0; i < ns.size(); ++i) {
+    ns[i] = static_cast<int>(i * 37 % 94);
+  }
+  std::vector<uint64_t> out(ns.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < ns.size(); ++i) {
+      out[i] = fibonacci(ns[i]);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * ns.size());
+}
+BENCHMARK(BM_FibonacciPerRow)->Arg(1 << 16);
+
+// Odd 64-bit candidates, most of which trial division rejects
+void BM_IsPrime(benchmark::State& state) {
+  std::vector<uint64_t> ns(1 << 12);
+  for (size_t i = 0; i < ns.size(); ++i) {
+    ns[i] = (i + 1) * 0x9E3779B97F4A7C15ULL | 1;
+  }
+  for (auto _ : state) {
+    size_t primes = 0;
+    for (const uint64_t n : ns) {
+      primes += is_prime(n);
+    }
+    benchmark::DoNotOptimize(primes);
+  }
+  state.SetItemsProcessed(state.iterations() * ns.size());
+}
+BENCHMARK(BM_IsPrime);
+
+void BM_PrimesUpTo(benchmark::State& state) {
+  const uint64_t n = state.range(0);
+  for (auto _ : state) {
+    auto primes = primes_up_to(n);
+    benchmark::DoNotOptimize(primes);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_PrimesUpTo)->Arg(1000000)->Arg(100000000)->Unit(benchmark::kMillisecond);
+
+// Text serialization of the primes below 10^7, into a fresh string and into
+// a buffer that is reused across iterations
+void BM_FormatNumberList(benchmark::State& state) {
+  const auto primes = primes_up_to(10000000);
+  for (auto _ : state) {
+    auto text = format_number_list(primes);
+    benchmark::DoNotOptimize(text);
+  }
+  state.SetItemsProcessed(state.iterations() * primes.size());
+}
+BENCHMARK(BM_FormatNumberList)->Unit(benchmark::kMillisecond);
+
+void BM_FormatNumberListInto(benchmark::State& state) {
+  const auto primes = primes_up_to(10000000);
+  std::vector<char> buffer(formatted_list_size(primes));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(format_number_list_to(primes, buffer));
+  }
+  state.SetItemsProcessed(state.iterations() * primes.size());
+}
+BENCHMARK(BM_FormatNumberListInto)->Unit(benchmark::kMillisecond);
+
+// Primes below 10^8 as text to /dev/null: streamed through write_primes, and
+// materialized with primes_up_to and format_number_list first
+void BM_WritePrimes(benchmark::State& state) {
+  const int fd = ::open("/dev/null", O_WRONLY);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(write_primes(fd, 0, 100000000));
+  }
+  ::close(fd);
+  state.SetItemsProcessed(state.iterations() * 100000000);
+}
+BENCHMARK(BM_WritePrimes)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+void BM_WritePrimesMaterialized(benchmark::State& state) {
+  const int fd = ::open("/dev/null", O_WRONLY);
+  for (auto _ : state) {
+    const std::string text = format_number_list(primes_up_to(100000000));
+    benchmark::DoNotOptimize(::write(fd, text.data(), text.size()));
+  }
+  ::close(fd);
+  state.SetItemsProcessed(state.iterations() * 100000000);
+}
+BENCHMARK(BM_WritePrimesMaterialized)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Scaling of the parallel sieve over 1..N threads at n = 10^9
+void BM_PrimesUpToParallel(benchmark::State& state) {
+  constexpr uint64_t kN = 1000000000;
+  const size_t threads = state.range(0);
+  for (auto _ : state) {
+    auto primes = primes_up_to(kN, threads);
+    benchmark::DoNotOptimize(primes);
+  }
+  state.SetItemsProcessed(state.iterations() * kN);
+}
+BENCHMARK(BM_PrimesUpToParallel)->Apply(ThreadCounts)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Count, sum, twins and gaps below 10^9 in one pass over the sieve, versus
+// materializing the primes first and walking them
+void BM_PrimeStats(benchmark::State& state) {
+  constexpr uint64_t kN = 1000000000;
+  for (auto _ : state) {
+    PrimeStats stats = prime_stats(0, kN);
+    benchmark::DoNotOptimize(stats);
+  }
+  state.SetItemsProcessed(state.iterations() * kN);
+}
+BENCHMARK(BM_PrimeStats)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+void BM_PrimeStatsMaterialized(benchmark::State& state) {
+  constexpr uint64_t kN = 1000000000;
+  for (auto _ : state) {
+    const std::vector<uint64_t> primes = primes_up_to(kN, 0);
+    PrimeStats stats;
+    stats.count = primes.size();
+    for (size_t i = 1; i < primes.size(); ++i) {
+      const uint64_t gap = primes[i] - primes[i - 1];
+      stats.sum += primes[i];
+      stats.twin_pairs += gap == 2;
+      if (gap >= stats.gap_histogram.size()) {
+        stats.gap_histogram.resize(gap + 1);
+      }
+      ++stats.gap_histogram[gap];
+      stats.max_gap = std::max(stats.max_gap, gap);
+    }
+    benchmark::DoNotOptimize(stats);
+  }
+  state.SetItemsProcessed(state.iterations() * kN);
+}
+BENCHMARK(BM_PrimeStatsMaterialized)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace ferric
+
+BENCHMARK_MAIN();
@@ -2,6 +2,14 @@
 
 #include <gtest/gtest.h>
 
+#include <iterator>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace ferric {
 namespace {
 
@@ -21,6 +29,75 @@ TEST(HelloLibTest, Fibonacci) {
   EXPECT_EQ(fibonacci(5), 5);
   EXPECT_EQ(fibonacci(10), 55);
   EXPECT_EQ(fibonacci(20), 6765);
+  EXPECT_EQ(fibonacci(93), 12200160415121876738ULL);
+
+  // Every n in range against the linear recurrence
+  uint64_t a = 0, b = 1;
+  for (int n = 0; n <= 93; ++n) {
+    ASSERT_EQ(fibonacci(n), a) << n;
+    b += a;
+    a = b - a;
+  }
+
+  EXPECT_THROW(fibonacci(94), std::out_of_range);
+  EXPECT_THROW(fibonacci(-1), std::out_of_range);
+}
+
+TEST(HelloLibTest, FibonacciBatch) {
+  const std::vector<int> ns = {0, 1, 2, 10, 93, 20, 5, 5, 0};
+  std::vector<uint64_t> out(ns.size());
+  fibonacci_batch(ns, out);
+  for (size_t i = 0; i < ns.size(); ++i) {
+    EXPECT_EQ(out[i], fibonacci(ns[i])) << ns[i];
+  }
+
+  // Long enough for every vector width plus a scalar tail
+  std::vector<int> many(1001);
+  for (size_t i = 0; i < many.size(); ++i) {
+    many[i] = static_cast<int>(i * 37 % 94);
+  }
+  std::vector<uint64_t> many_out(many.size());
+  fibonacci_batch(many, many_out);
+  for (size_t i = 0; i < many.size(); ++i) {
+    ASSERT_EQ(many_out[i], fibonacci(many[i])) << i;
+  }
+
+  fibonacci_batch({}, {});
+  // A bad index is caught in the vector body as well as in the scalar tail
+  for (const int bad : {94, -1, std::numeric_limits<int>::min()}) {
+    for (const size_t at : {size_t{3}, size_t{999}}) {
+      std::vector<int> with_bad = many;
+      with_bad[at] = bad;
+      EXPECT_THROW(fibonacci_batch(with_bad, many_out), std::out_of_range) << bad << " at " << at;
+    }
+  }
+  EXPECT_THROW(fibonacci_batch(ns, std::span<uint64_t>(out).first(3)), std::invalid_argument);
+}
+
+// Both fold to constants at compile time
+static_assert(fibonacci(10) == 55);
+static_assert(fibonacci(93) == 12200160415121876738ULL);
+static_assert(is_prime(65521) && !is_prime(65535));
+static_assert(is_prime(18446744073709551557ULL) && !is_prime(18446744073709551615ULL));
+
+TEST(HelloLibTest, FibonacciBig) {
+  EXPECT_TRUE(fibonacci_big(0).is_zero());
+  for (int n = 1; n <= 93; ++n) {
+    ASSERT_EQ(fibonacci_big(n), BigUint(fibonacci(n))) << n;
+  }
+  EXPECT_EQ(fibonacci_big(100).to_string(), "354224848179261915075");
+  EXPECT_EQ(fibonacci_big(1000).to_string(),
+            "43466557686937456435688527675040625802564660517371780402481729089536555417949051890"
+            "40387984007925516929592259308032263477520968962323987332247116164299644090653318793"
+            "8298969649928516003704476137795166849228875");
+
+  // F(100000) has 20899 digits; check its size, leading digits and low limb
+  const BigUint big = fibonacci_big(100000);
+  EXPECT_EQ(big.bit_width(), 69424);
+  EXPECT_EQ(big.limbs()[0], 2754320626097736315ULL);
+  const std::string digits = big.to_string();
+  EXPECT_EQ(digits.size(), 20899);
+  EXPECT_EQ(digits.substr(0, 20), "25974069347221724166");
 }
 
 TEST(HelloLibTest, IsPrime) {
@@ -35,12 +112,178 @@ TEST(HelloLibTest, IsPrime) {
   EXPECT_FALSE(is_prime(100));
 }
 
+TEST(HelloLibTest, IsPrimeMatchesSieve) {
+  auto primes = primes_up_to(100000);
+  size_t next = 0;
+  for (uint64_t n = 0; n <= 100000; ++n) {
+    const bool expected = next < primes.size() && primes[next] == n;
+    EXPECT_EQ(is_prime(n), expected) << n;
+    next += expected;
+  }
+}
+
+TEST(HelloLibTest, IsPrimeLarge) {
+  EXPECT_TRUE(is_prime(4294967291ULL));             // Largest prime below 2^32
+  EXPECT_TRUE(is_prime(2305843009213693951ULL));    // 2^61 - 1
+  EXPECT_TRUE(is_prime(18446744073709551557ULL));   // Largest prime below 2^64
+  EXPECT_FALSE(is_prime(18446744073709551615ULL));  // 2^64 - 1
+  EXPECT_FALSE(is_prime(18446743979220271189ULL));  // 4294967291 * 4294967279
+
+  // Carmichael numbers and strong pseudoprimes to small bases
+  EXPECT_FALSE(is_prime(561));
+  EXPECT_FALSE(is_prime(3215031751ULL));
+  EXPECT_FALSE(is_prime(3825123056546413051ULL));
+  EXPECT_FALSE(is_prime(341550071728321ULL));
+}
+
+TEST(HelloLibTest, IsPrimeBatch) {
+  std::vector<uint64_t> candidates;
+  for (uint64_t n = 0; n < 3000; ++n) {
+    candidates.push_back(n);
+  }
+  for (uint64_t n = 18446744073709551615ULL; n > 18446744073709550615ULL; --n) {
+    candidates.push_back(n);
+  }
+  candidates.push_back(3825123056546413051ULL);
+  candidates.push_back(2305843009213693951ULL);
+
+  std::vector<uint8_t> results(candidates.size());
+  is_prime_batch(candidates, results);
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    EXPECT_EQ(results[i], is_prime(candidates[i])) << candidates[i];
+  }
+
+  std::vector<uint8_t> too_short(1);
+  EXPECT_THROW(is_prime_batch(candidates, too_short), std::invalid_argument);
+}
+
 TEST(HelloLibTest, PrimesUpTo) {
   auto primes = primes_up_to(20);
   std::vector<uint64_t> expected = {2, 3, 5, 7, 11, 13, 17, 19};
   EXPECT_EQ(primes, expected);
 }
 
+TEST(HelloLibTest, PrimesUpToReservesOnce) {
+  for (uint64_t n : {0, 1, 2, 1000, 355990, 355991, 10000000}) {
+    const auto primes = primes_up_to(n);
+    const uint64_t bound = prime_count_upper_bound(n);
+    ASSERT_GE(bound, primes.size()) << n;
+    // Either the single reservation survives untouched, or its slack was over
+    // 1/64 of the result and was trimmed away; growth by doubling gives neither
+    const bool trimmed = bound - primes.size() > primes.size() / 64;
+    EXPECT_EQ(primes.capacity(), trimmed ? primes.size() : bound) << n;
+  }
+  // Large n keeps the reservation rather than copying the result to trim it
+  EXPECT_EQ(primes_up_to(10000000).capacity(), prime_count_upper_bound(10000000));
+}
+
+TEST(HelloLibTest, PrimesUpToSinks) {
+  const auto expected = primes_up_to(1000000);
+
+  std::vector<uint64_t> buffer(prime_count_upper_bound(1000000), 0);
+  EXPECT_EQ(primes_up_to(1000000, buffer.data()), buffer.data() + expected.size());
+  buffer.resize(expected.size());
+  EXPECT_EQ(buffer, expected);
+
+  std::vector<uint64_t> appended = {1};
+  primes_up_to(20, std::back_inserter(appended));
+  EXPECT_EQ(appended, std::vector<uint64_t>({1, 2, 3, 5, 7, 11, 13, 17, 19}));
+
+  std::vector<uint64_t> exact(expected.size());
+  EXPECT_EQ(primes_up_to(1000000, std::span<uint64_t>(exact)), expected.size());
+  EXPECT_EQ(exact, expected);
+  EXPECT_EQ(primes_up_to(1, std::span<uint64_t>()), 0);
+  std::vector<uint64_t> short_by_one(expected.size() - 1);
+  EXPECT_THROW(primes_up_to(1000000, std::span<uint64_t>(short_by_one)), std::invalid_argument);
+}
+
+TEST(HelloLibTest, PrimesUpToParallel) {
+  EXPECT_TRUE(primes_up_to(1, 4).empty());
+  EXPECT_EQ(primes_up_to(20, 4), primes_up_to(20));
+
+  const auto expected = primes_up_to(20000000);
+  EXPECT_EQ(expected.size(), 1270607);
+  for (size_t threads : {1, 2, 3, 8}) {
+    EXPECT_EQ(primes_up_to(20000000, threads), expected) << threads << " threads";
+  }
+}
+
+TEST(HelloLibTest, PrimesInRange) {
+  EXPECT_TRUE(primes_in_range(24, 29).empty());
+  EXPECT_TRUE(primes_in_range(30, 10).empty());
+  EXPECT_EQ(primes_in_range(0, 21), primes_up_to(20));
+  EXPECT_EQ(primes_in_range(90, 110), std::vector<uint64_t>({97, 101, 103, 107, 109}));
+
+  // Windows far from 2, split across several workers
+  for (uint64_t lo : {1000000000000ULL, 1000000000000000000ULL}) {
+    std::vector<uint64_t> expected;
+    for (uint64_t n = lo; n < lo + 2000000; ++n) {
+      if (is_prime(n)) {
+        expected.push_back(n);
+      }
+    }
+    for (size_t threads : {1, 3}) {
+      EXPECT_EQ(primes_in_range(lo, lo + 2000000, threads), expected)
+          << "lo = " << lo << ", " << threads << " threads";
+    }
+  }
+}
+
+TEST(HelloLibTest, PrimeCount) {
+  EXPECT_EQ(prime_count(0), 0);
+  EXPECT_EQ(prime_count(1), 0);
+  EXPECT_EQ(prime_count(2), 1);
+  EXPECT_EQ(prime_count(3), 2);
+  EXPECT_EQ(prime_count(100), 25);
+
+  // Every x up to a few thousand, against the sieve
+  auto primes = primes_up_to(5000);
+  size_t count = 0;
+  for (uint64_t x = 0; x <= 5000; ++x) {
+    while (count < primes.size() && primes[count] <= x) {
+      ++count;
+    }
+    ASSERT_EQ(prime_count(x), count) << x;
+  }
+
+  EXPECT_EQ(prime_count(1000000), 78498);
+  EXPECT_EQ(prime_count(1000000007), 50847535);
+  EXPECT_EQ(prime_count(10000000000ULL), 455052511);
+}
+
+TEST(HelloLibTest, PrimeCountUpperBound) {
+  EXPECT_EQ(prime_count_upper_bound(0), 0);
+  EXPECT_EQ(prime_count_upper_bound(1), 0);
+  auto primes = primes_up_to(400000);
+  size_t count = 0;
+  for (uint64_t x = 0; x <= 400000; ++x) {
+    while (count < primes.size() && primes[count] <= x) {
+      ++count;
+    }
+    ASSERT_GE(prime_count_upper_bound(x), count) << x;
+  }
+  // pi(10^k), and the bound within 0.1% of it
+  const std::vector<std::pair<uint64_t, uint64_t>> known = {
+      {1000000, 78498},
+      {1000000000, 50847534},
+      {1000000000000, 37607912018},
+      {1000000000000000000, 24739954287740860},
+  };
+  for (const auto& [x, pi] : known) {
+    EXPECT_GE(prime_count_upper_bound(x), pi) << x;
+    EXPECT_LE(prime_count_upper_bound(x), pi + pi / 1000) << x;
+  }
+  EXPECT_GT(prime_count_upper_bound(std::numeric_limits<uint64_t>::max()), uint64_t{1} << 58);
+}
+
+TEST(HelloLibTest, PrimeRange) {
+  std::vector<uint64_t> primes;
+  for (uint64_t p : prime_range(0, 21)) {
+    primes.push_back(p);
+  }
+  EXPECT_EQ(primes, primes_up_to(20));
+}
+
 TEST(HelloLibTest, FormatNumberList) {
   std::vector<uint64_t> numbers = {2, 3, 5, 7, 11};
   EXPECT_EQ(format_number_list(numbers), "2, 3, 5, 7, 11");
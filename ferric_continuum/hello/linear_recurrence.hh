@@ -0,0 +1,170 @@
+#pragma once
+
+#include "montgomery.hh"
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+namespace ferric {
+
+// Arithmetic a LinearRecurrence runs on. Values may be kept in an internal
+// representation: encode() maps a plain value into it and decode() back.
+template <typename R, typename T>
+concept RecurrenceRing = requires(const R& ring, const T& a, const T& b) {
+  { ring.zero() } -> std::convertible_to<T>;
+  { ring.add(a, b) } -> std::convertible_to<T>;
+  { ring.mul(a, b) } -> std::convertible_to<T>;
+  { ring.encode(a) } -> std::convertible_to<T>;
+  { ring.decode(a) } -> std::convertible_to<T>;
+};
+
+// The type's own + and *: uint64_t wraps mod 2^64, BigUint is exact
+template <typename T>
+struct NaturalRing {
+  T zero() const { return T(0); }
+  T add(const T& a, const T& b) const { return a + b; }
+  T mul(const T& a, const T& b) const { return a * b; }
+  T encode(const T& a) const { return a; }
+  T decode(const T& a) const { return a; }
+};
+
+// Integers mod m for any m >= 1. Odd moduli run in Montgomery form, so
+// products need no hardware division; even moduli fall back to 128-bit %.
+class ModularRing {
+ public:
+  explicit ModularRing(uint64_t m) : m_(m), mont_(m % 2 ? m : 1) {
+    if (m == 0) {
+      throw std::invalid_argument("ModularRing: modulus must be positive");
+    }
+  }
+
+  uint64_t modulus() const { return m_; }
+
+  uint64_t zero() const { return 0; }
+  uint64_t add(uint64_t a, uint64_t b) const {
+    const uint64_t s = a + b;
+    return (s < a || s >= m_) ? s - m_ : s;
+  }
+  uint64_t mul(uint64_t a, uint64_t b) const {
+    if (m_ % 2) {
+      return mont_.mul(a, b);
+    }
+    return static_cast<uint64_t>(static_cast<unsigned __int128>(a) * b % m_);
+  }
+  uint64_t encode(uint64_t a) const { return m_ % 2 ? mont_.to_montgomery(a) : a % m_; }
+  uint64_t decode(uint64_t a) const { return m_ % 2 ? mont_.from_montgomery(a) : a; }
+
+ private:
+  uint64_t m_;
+  Montgomery64 mont_;  // Unused for even moduli
+};
+
+// n-th term of an order-K linear recurrence
+//
+//   a(n) = c[0] a(n-1) + c[1] a(n-2) + ... + c[K-1] a(n-K)
+//
+// by Kitamasa's method: a(n) = sum r_i a(i), where r(x) = x^n mod the
+// characteristic polynomial x^K - c[0] x^(K-1) - ... - c[K-1]. The power is
+// built by repeated squaring, O(K^2) ring operations per bit of n, and only
+// needs addition and multiplication, so it also runs over rings without
+// subtraction such as BigUint.
+//
+//   LinearRecurrence<uint64_t, 3> tribonacci({1, 1, 1}, {0, 0, 1});
+//   LinearRecurrence<uint64_t, 2, ModularRing> fib_mod({1, 1}, {0, 1}, ModularRing(m));
+//   LinearRecurrence<BigUint, 2> fib_big({BigUint(1), BigUint(1)}, {BigUint(0), BigUint(1)});
+template <typename T, size_t K, typename Ring = NaturalRing<T>>
+  requires(K > 0 && RecurrenceRing<Ring, T>)
+class LinearRecurrence {
+ public:
+  // coefficients c[0..K-1] as above; initial holds a(0) through a(K-1)
+  LinearRecurrence(const std::array<T, K>& coefficients, const std::array<T, K>& initial,
+                   Ring ring = Ring())
+      : ring_(std::move(ring)) {
+    for (size_t i = 0; i < K; ++i) {
+      coefficients_[i] = ring_.encode(coefficients[i]);
+      initial_[i] = ring_.encode(initial[i]);
+    }
+  }
+
+  const Ring& ring() const { return ring_; }
+
+  // a(n)
+  T operator()(uint64_t n) const {
+    if (n < K) {
+      return ring_.decode(initial_[n]);
+    }
+    // r = x^n mod the characteristic polynomial, from the top bit of n down
+    Poly r = unit();
+    for (int bit = std::bit_width(n) - 1; bit >= 0; --bit) {
+      r = square_mod(r);
+      if (n >> bit & 1) {
+        times_x_mod(r);
+      }
+    }
+    T term = ring_.zero();
+    for (size_t i = 0; i < K; ++i) {
+      term = ring_.add(term, ring_.mul(r[i], initial_[i]));
+    }
+    return ring_.decode(term);
+  }
+
+ private:
+  using Poly = std::array<T, K>;  // Coefficients of x^0 .. x^(K-1)
+
+  Poly unit() const {
+    Poly p;
+    p.fill(ring_.zero());
+    p[0] = ring_.encode(T(1));
+    return p;
+  }
+
+  // Fold x^j for j >= K back down using x^K = c[0] x^(K-1) + ... + c[K-1]
+  void reduce(std::array<T, 2 * K - 1>& wide) const {
+    for (size_t j = 2 * K - 1; j-- > K;) {
+      for (size_t i = 0; i < K; ++i) {
+        wide[j - 1 - i] = ring_.add(wide[j - 1 - i], ring_.mul(wide[j], coefficients_[i]));
+      }
+    }
+  }
+
+  Poly square_mod(const Poly& p) const {
+    std::array<T, 2 * K - 1> wide;
+    wide.fill(ring_.zero());
+    // Each cross product p[i] p[j] is formed once and added twice
+    for (size_t i = 0; i < K; ++i) {
+      wide[2 * i] = ring_.add(wide[2 * i], ring_.mul(p[i], p[i]));
+      for (size_t j = i + 1; j < K; ++j) {
+        const T cross = ring_.mul(p[i], p[j]);
+        wide[i + j] = ring_.add(wide[i + j], ring_.add(cross, cross));
+      }
+    }
+    reduce(wide);
+    Poly result;
+    for (size_t i = 0; i < K; ++i) {
+      result[i] = std::move(wide[i]);
+    }
+    return result;
+  }
+
+  void times_x_mod(Poly& p) const {
+    T top = std::move(p[K - 1]);
+    for (size_t i = K - 1; i > 0; --i) {
+      p[i] = std::move(p[i - 1]);
+    }
+    p[0] = ring_.zero();
+    for (size_t i = 0; i < K; ++i) {
+      p[K - 1 - i] = ring_.add(p[K - 1 - i], ring_.mul(top, coefficients_[i]));
+    }
+  }
+
+  Ring ring_;
+  std::array<T, K> coefficients_;
+  std::array<T, K> initial_;
+};
+
+}  // namespace ferric
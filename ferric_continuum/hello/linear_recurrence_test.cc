@@ -0,0 +1,83 @@
+#include "linear_recurrence.hh"
+
+#include "big_int.hh"
+#include "fibonacci_mod.hh"
+#include "hello_lib.hh"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+TEST(LinearRecurrenceTest, FibonacciOverUint64) {
+  const LinearRecurrence<uint64_t, 2> fib({1, 1}, {0, 1});
+  for (int n = 0; n <= kMaxFibonacci; ++n) {
+    ASSERT_EQ(fib(n), fibonacci(n)) << n;
+  }
+}
+
+TEST(LinearRecurrenceTest, TribonacciWrapsLikeTheLoop) {
+  const LinearRecurrence<uint64_t, 3> tribonacci({1, 1, 1}, {0, 0, 1});
+  uint64_t a = 0, b = 0, c = 1;
+  for (uint64_t n = 0; n < 300; ++n) {
+    ASSERT_EQ(tribonacci(n), a) << n;
+    const uint64_t next = a + b + c;
+    a = b;
+    b = c;
+    c = next;
+  }
+  EXPECT_EQ(tribonacci(37), 1132436852);
+}
+
+TEST(LinearRecurrenceTest, OrderOne) {
+  const LinearRecurrence<uint64_t, 1> powers_of_three({3}, {1});
+  uint64_t expected = 1;
+  for (uint64_t n = 0; n < 100; ++n) {
+    ASSERT_EQ(powers_of_three(n), expected) << n;
+    expected *= 3;
+  }
+}
+
+TEST(LinearRecurrenceTest, ModularMatchesFibonacciMod) {
+  for (uint64_t m : std::vector<uint64_t>{1, 2, 1000000007, 1ULL << 40, 18446744073709551615ULL}) {
+    const LinearRecurrence<uint64_t, 2, ModularRing> fib({1, 1}, {0, 1}, ModularRing(m));
+    for (uint64_t n :
+         std::vector<uint64_t>{0, 1, 2, 93, 1000, 1000000000000000000ULL, UINT64_MAX}) {
+      EXPECT_EQ(fib(n), fibonacci_mod(n, m)) << "n = " << n << ", m = " << m;
+    }
+  }
+  EXPECT_THROW(ModularRing(0), std::invalid_argument);
+}
+
+TEST(LinearRecurrenceTest, CustomModularRecurrence) {
+  // a(n) = 2 a(n-1) + 7 a(n-3) + 5 a(n-5) with arbitrary start, odd and even moduli
+  const std::array<uint64_t, 5> c = {2, 0, 7, 0, 5};
+  const std::array<uint64_t, 5> init = {3, 1, 4, 1, 5};
+  for (uint64_t m : std::vector<uint64_t>{998244353, 1000000000000ULL}) {
+    const LinearRecurrence<uint64_t, 5, ModularRing> rec(c, init, ModularRing(m));
+    std::vector<uint64_t> a(init.begin(), init.end());
+    for (size_t n = 5; n < 500; ++n) {
+      unsigned __int128 next = 0;
+      for (size_t i = 0; i < 5; ++i) {
+        next += static_cast<unsigned __int128>(c[i]) * a[n - 1 - i];
+      }
+      a.push_back(static_cast<uint64_t>(next % m));
+    }
+    for (size_t n = 0; n < a.size(); ++n) {
+      ASSERT_EQ(rec(n), a[n] % m) << "n = " << n << ", m = " << m;
+    }
+  }
+}
+
+TEST(LinearRecurrenceTest, BigIntegers) {
+  const LinearRecurrence<BigUint, 2> fib({BigUint(1), BigUint(1)}, {BigUint(0), BigUint(1)});
+  for (uint64_t n : {0, 1, 2, 94, 1000, 12345}) {
+    EXPECT_EQ(fib(n), fibonacci_big(n)) << n;
+  }
+}
+
+}  // namespace
+}  // namespace ferric
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ferric {
+
+// Coalesces concurrent calls into batched kernel calls.
+//
+// Each run() enqueues its inputs and blocks. A flusher thread calls the kernel
+// once over everything queued as soon as max_batch inputs are waiting, or
+// max_delay after the oldest call arrived, whichever comes first, so a lone
+// caller waits at most max_delay and busy periods pay one kernel call per
+// batch. A single call larger than max_batch is never split.
+template <typename In, typename Out>
+class MicroBatcher {
+ public:
+  // kernel(in, out) must fill out[i] from in[i]; the spans have equal size
+  using Kernel = std::function<void(std::span<const In>, std::span<Out>)>;
+
+  MicroBatcher(Kernel kernel, size_t max_batch, std::chrono::microseconds max_delay)
+      : kernel_(std::move(kernel)), max_batch_(max_batch), max_delay_(max_delay) {
+    flusher_ = std::thread([this] { flush_loop(); });
+  }
+
+  // Finishes every queued call before joining
+  ~MicroBatcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    queued_.notify_one();
+    flusher_.join();
+  }
+
+  MicroBatcher(const MicroBatcher&) = delete;
+  MicroBatcher& operator=(const MicroBatcher&) = delete;
+
+  // kernel(inputs) as part of some batch; rethrows the kernel's exception if
+  // the batch failed
+  std::vector<Out> run(std::span<const In> inputs) {
+    std::vector<Out> outputs(inputs.size());
+    if (inputs.empty()) {
+      return outputs;
+    }
+    Call call{inputs, outputs, std::chrono::steady_clock::now(), false, nullptr};
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_.push_back(&call);
+    pending_inputs_ += inputs.size();
+    queued_.notify_one();
+    flushed_.wait(lock, [&] { return call.done; });
+    if (call.error) {
+      std::rethrow_exception(call.error);
+    }
+    return outputs;
+  }
+
+  // Kernel calls so far, and the run() calls they served
+  uint64_t batches() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batches_;
+  }
+  uint64_t calls() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return calls_;
+  }
+
+ private:
+  struct Call {
+    std::span<const In> inputs;
+    std::span<Out> outputs;
+    std::chrono::steady_clock::time_point arrival;
+    bool done = false;
+    std::exception_ptr error;
+  };
+
+  void flush_loop() {
+    std::vector<Call*> batch;
+    std::vector<In> inputs;
+    std::vector<Out> outputs;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      queued_.wait(lock, [&] { return !pending_.empty() || stopping_; });
+      if (pending_.empty()) {
+        return;
+      }
+      // Linger for more calls until the batch is full or the oldest is due
+      const auto deadline = pending_.front()->arrival + max_delay_;
+      queued_.wait_until(lock, deadline,
+                         [&] { return pending_inputs_ >= max_batch_ || stopping_; });
+
+      batch.clear();
+      size_t count = 0;
+      while (!pending_.empty() && (batch.empty() || count + pending_.front()->inputs.size() <=
+                                                        max_batch_)) {
+        batch.push_back(pending_.front());
+        count += pending_.front()->inputs.size();
+        pending_.pop_front();
+      }
+      pending_inputs_ -= count;
+      ++batches_;
+      calls_ += batch.size();
+      lock.unlock();
+
+      // Callers' spans stay valid until they are marked done
+      inputs.clear();
+      for (const Call* call : batch) {
+        inputs.insert(inputs.end(), call->inputs.begin(), call->inputs.end());
+      }
+      outputs.resize(inputs.size());
+      std::exception_ptr error;
+      try {
+        kernel_(inputs, outputs);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      lock.lock();
+      size_t offset = 0;
+      for (Call* call : batch) {
+        if (!error) {
+          std::copy_n(outputs.begin() + offset, call->outputs.size(), call->outputs.begin());
+        }
+        offset += call->outputs.size();
+        call->error = error;
+        call->done = true;
+      }
+      flushed_.notify_all();
+    }
+  }
+
+  Kernel kernel_;
+  size_t max_batch_;
+  std::chrono::microseconds max_delay_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable queued_;   // A call arrived, or stopping_ was set
+  std::condition_variable flushed_;  // Some batch finished
+  std::deque<Call*> pending_;
+  size_t pending_inputs_ = 0;
+  bool stopping_ = false;
+  uint64_t batches_ = 0;
+  uint64_t calls_ = 0;
+  std::thread flusher_;
+};
+
+}  // namespace ferric
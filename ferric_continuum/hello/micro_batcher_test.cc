@@ -0,0 +1,71 @@
+#include "micro_batcher.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+using namespace std::chrono_literals;
+
+TEST(MicroBatcherTest, CoalescesConcurrentCalls) {
+  // The batch fills exactly when the last call arrives and the delay never
+  // expires, so every call lands in one kernel call however the threads start
+  constexpr int kThreads = 16;
+  std::atomic<int> kernel_calls = 0;
+  MicroBatcher<int, int> squares(
+      [&](std::span<const int> in, std::span<int> out) {
+        ++kernel_calls;
+        for (size_t i = 0; i < in.size(); ++i) {
+          out[i] = in[i] * in[i];
+        }
+      },
+      kThreads * 3, 60s);
+
+  std::vector<std::thread> threads;
+  std::vector<std::vector<int>> results(kThreads);
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t] {
+      const std::vector<int> in = {t, t + 1, t + 2};
+      results[t] = squares.run(in);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < kThreads; ++t) {
+    EXPECT_EQ(results[t], std::vector<int>({t * t, (t + 1) * (t + 1), (t + 2) * (t + 2)}));
+  }
+  EXPECT_EQ(squares.calls(), kThreads);
+  EXPECT_EQ(squares.batches(), 1);
+  EXPECT_EQ(kernel_calls.load(), 1);
+}
+
+TEST(MicroBatcherTest, FlushesFullBatchesWithoutWaiting) {
+  MicroBatcher<int, int> identity(
+      [](std::span<const int> in, std::span<int> out) {
+        std::copy(in.begin(), in.end(), out.begin());
+      },
+      4, 10s);
+  const std::vector<int> in = {1, 2, 3, 4, 5};
+  const auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(identity.run(in), in);  // Oversized calls go out alone
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+  EXPECT_TRUE(identity.run(std::vector<int>()).empty());
+}
+
+TEST(MicroBatcherTest, PropagatesKernelErrors) {
+  MicroBatcher<int, int> failing(
+      [](std::span<const int>, std::span<int>) { throw std::runtime_error("kernel failed"); }, 16,
+      1ms);
+  EXPECT_THROW(failing.run(std::vector<int>({1})), std::runtime_error);
+}
+
+}  // namespace
+}  // namespace ferric
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ferric {
+
+// n^-1 mod 2^64 for odd n by Newton iteration: n is its own inverse to 3 bits,
+// and each step doubles the correct low bits. Shared by Montgomery64 and the
+// division-free trial division in primality.hh.
+constexpr uint64_t inverse_mod_2_64(uint64_t n) {
+  uint64_t inv = n;
+  for (int i = 0; i < 5; ++i) {
+    inv *= 2 - n * inv;
+  }
+  return inv;
+}
+
+// Montgomery arithmetic modulo an odd 64-bit modulus.
+//
+// Values live in Montgomery form (a * 2^64 mod n), so a modular product is
+// two 64x64->128 multiplies and a subtraction instead of a 128-bit division.
+// Every odd n < 2^64 is supported; all operands must already be reduced.
+class Montgomery64 {
+ public:
+  constexpr explicit Montgomery64(uint64_t n) : n_(n), inv_(inverse_mod_2_64(n)) {
+    const uint64_t r = (0 - n) % n;  // 2^64 mod n
+    one_ = r;
+    r2_ = static_cast<uint64_t>(static_cast<unsigned __int128>(r) * r % n);
+  }
+
+  constexpr uint64_t modulus() const { return n_; }
+
+  // Montgomery forms of 1 and n - 1
+  constexpr uint64_t one() const { return one_; }
+  constexpr uint64_t minus_one() const { return n_ - one_; }
+
+  constexpr uint64_t to_montgomery(uint64_t a) const { return mul(a % n_, r2_); }
+  constexpr uint64_t from_montgomery(uint64_t a) const { return reduce(a); }
+
+  constexpr uint64_t mul(uint64_t a, uint64_t b) const {
+    return reduce(static_cast<unsigned __int128>(a) * b);
+  }
+
+  constexpr uint64_t add(uint64_t a, uint64_t b) const {
+    const uint64_t s = a + b;
+    return (s < a || s >= n_) ? s - n_ : s;
+  }
+
+  constexpr uint64_t sub(uint64_t a, uint64_t b) const { return a >= b ? a - b : a - b + n_; }
+
+  // base^e with base in Montgomery form; the result is in Montgomery form
+  constexpr uint64_t pow(uint64_t base, uint64_t e) const {
+    uint64_t result = one_;
+    while (e) {
+      if (e & 1) {
+        result = mul(result, base);
+      }
+      base = mul(base, base);
+      e >>= 1;
+    }
+    return result;
+  }
+
+ private:
+  // t * 2^-64 mod n for t < n * 2^64
+  constexpr uint64_t reduce(unsigned __int128 t) const {
+    const uint64_t m = static_cast<uint64_t>(t) * inv_;
+    const uint64_t mn_hi = static_cast<uint64_t>((static_cast<unsigned __int128>(m) * n_) >> 64);
+    const uint64_t t_hi = static_cast<uint64_t>(t >> 64);
+    return t_hi >= mn_hi ? t_hi - mn_hi : t_hi - mn_hi + n_;
+  }
+
+  uint64_t n_;
+  uint64_t inv_;
+  uint64_t one_ = 0;
+  uint64_t r2_ = 0;
+};
+
+}  // namespace ferric
@@ -0,0 +1,58 @@
+#include "montgomery.hh"
+
+#include <gtest/gtest.h>
+
+namespace ferric {
+namespace {
+
+static_assert(inverse_mod_2_64(1) == 1 && 3 * inverse_mod_2_64(3) == 1);
+static_assert(0xFFFFFFFFFFFFFFC5ULL * inverse_mod_2_64(0xFFFFFFFFFFFFFFC5ULL) == 1);
+
+uint64_t mulmod(uint64_t a, uint64_t b, uint64_t n) {
+  return static_cast<uint64_t>(static_cast<unsigned __int128>(a) * b % n);
+}
+
+TEST(MontgomeryTest, RoundTrip) {
+  const Montgomery64 mont(1000003);
+  for (uint64_t a : {0ULL, 1ULL, 2ULL, 999999ULL, 1000002ULL}) {
+    EXPECT_EQ(mont.from_montgomery(mont.to_montgomery(a)), a);
+  }
+  EXPECT_EQ(mont.from_montgomery(mont.one()), 1);
+  EXPECT_EQ(mont.from_montgomery(mont.minus_one()), 1000002);
+}
+
+TEST(MontgomeryTest, MatchesWideArithmetic) {
+  // Moduli on both sides of 2^63, where the reduction must not overflow
+  for (uint64_t n : {3ULL, 1000003ULL, 9223372036854775783ULL, 18446744073709551557ULL,
+                     18446744073709551615ULL}) {
+    const Montgomery64 mont(n);
+    const uint64_t a = n - 2;
+    const uint64_t b = n / 3 + 1;
+    const uint64_t am = mont.to_montgomery(a);
+    const uint64_t bm = mont.to_montgomery(b);
+    EXPECT_EQ(mont.from_montgomery(mont.mul(am, bm)), mulmod(a, b, n)) << n;
+    EXPECT_EQ(mont.from_montgomery(mont.add(am, bm)),
+              static_cast<uint64_t>((static_cast<unsigned __int128>(a) + b) % n))
+        << n;
+    EXPECT_EQ(mont.from_montgomery(mont.sub(bm, am)),
+              static_cast<uint64_t>((static_cast<unsigned __int128>(b) + n - a) % n))
+        << n;
+  }
+}
+
+TEST(MontgomeryTest, Pow) {
+  // Fermat: a^(p-1) = 1 mod p
+  const uint64_t p = 18446744073709551557ULL;
+  const Montgomery64 mont(p);
+  EXPECT_EQ(mont.pow(mont.to_montgomery(3), p - 1), mont.one());
+  EXPECT_EQ(mont.from_montgomery(mont.pow(mont.to_montgomery(2), 10)), 1024);
+}
+
+TEST(MontgomeryTest, Constexpr) {
+  constexpr Montgomery64 mont(97);
+  static_assert(mont.from_montgomery(mont.mul(mont.to_montgomery(10), mont.to_montgomery(20))) ==
+                200 % 97);
+}
+
+}  // namespace
+}  // namespace ferric
@@ -0,0 +1,107 @@
+#include "number_format.hh"
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace ferric {
+
+namespace {
+
+// "00" "01" ... "99": one load and one two-byte store per pair of digits
+constexpr std::array<char, 200> make_digit_pairs() {
+  std::array<char, 200> pairs{};
+  for (int i = 0; i < 100; ++i) {
+    pairs[2 * i] = static_cast<char>('0' + i / 10);
+    pairs[2 * i + 1] = static_cast<char>('0' + i % 10);
+  }
+  return pairs;
+}
+
+constexpr std::array<char, 200> kDigitPairs = make_digit_pairs();
+
+// Fill the digits of v backwards, ending just before end
+void write_digits_backward(uint64_t v, char* end) {
+  // Above 2^32 every division is a 64-bit multiply-high; below it the
+  // compiler switches to cheaper 32-bit reciprocals
+  while (v >= (uint64_t{1} << 32)) {
+    const uint64_t q = v / 100;
+    end -= 2;
+    std::memcpy(end, &kDigitPairs[2 * (v - q * 100)], 2);
+    v = q;
+  }
+  uint32_t w = static_cast<uint32_t>(v);
+  while (w >= 100) {
+    const uint32_t q = w / 100;
+    end -= 2;
+    std::memcpy(end, &kDigitPairs[2 * (w - q * 100)], 2);
+    w = q;
+  }
+  if (w >= 10) {
+    std::memcpy(end - 2, &kDigitPairs[2 * w], 2);
+  } else {
+    end[-1] = static_cast<char>('0' + w);
+  }
+}
+
+// Caller guarantees out holds formatted_list_size bytes
+char* write_list(std::span<const uint64_t> numbers, char* out, absl::string_view separator) {
+  for (size_t i = 0; i < numbers.size(); ++i) {
+    if (i > 0) {
+      std::memcpy(out, separator.data(), separator.size());
+      out += separator.size();
+    }
+    out = write_decimal(numbers[i], out);
+  }
+  return out;
+}
+
+// Cord copies appended chunks this small into its own nodes, so lists up to
+// this size are formatted on the stack rather than into an external buffer
+constexpr size_t kCordCopyLimit = 512;
+
+}  // namespace
+
+char* write_decimal(uint64_t v, char* out) {
+  char* end = out + decimal_digits(v);
+  write_digits_backward(v, end);
+  return end;
+}
+
+size_t formatted_list_size(std::span<const uint64_t> numbers, absl::string_view separator) {
+  if (numbers.empty()) {
+    return 0;
+  }
+  size_t size = (numbers.size() - 1) * separator.size();
+  for (const uint64_t v : numbers) {
+    size += decimal_digits(v);
+  }
+  return size;
+}
+
+size_t format_number_list_to(std::span<const uint64_t> numbers, std::span<char> out,
+                             absl::string_view separator) {
+  if (out.size() < formatted_list_size(numbers, separator)) {
+    throw std::invalid_argument("format_number_list_to: output buffer is too small");
+  }
+  return write_list(numbers, out.data(), separator) - out.data();
+}
+
+void append_number_list(std::span<const uint64_t> numbers, absl::Cord& cord,
+                        absl::string_view separator) {
+  const size_t size = formatted_list_size(numbers, separator);
+  if (size <= kCordCopyLimit) {
+    std::array<char, kCordCopyLimit> text;
+    write_list(numbers, text.data(), separator);
+    cord.Append(absl::string_view(text.data(), size));
+    return;
+  }
+  // Left uninitialized: write_list fills every byte
+  std::unique_ptr<char[]> text(new char[size]);
+  write_list(numbers, text.get(), separator);
+  cord.Append(absl::MakeCordFromExternal(absl::string_view(text.release(), size),
+                                         [](absl::string_view chunk) { delete[] chunk.data(); }));
+}
+
+}  // namespace ferric
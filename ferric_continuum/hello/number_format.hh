@@ -0,0 +1,65 @@
+#pragma once
+
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+
+namespace ferric {
+
+// Decimal formatting of uint64_t lists without intermediate strings. The exact
+// output length is computed first, so callers size their buffer once.
+
+inline constexpr std::array<uint64_t, 20> kPowersOf10 = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+    10000000000000000000ULL};
+
+// Number of decimal digits in v (1 for 0), without a loop: bit_width * 1233 /
+// 4096 is floor(log10(2^bit_width)), which is off by at most one. Setting the
+// low bit changes no digit count but makes 0 count as 1.
+constexpr int decimal_digits(uint64_t v) {
+  v |= 1;
+  const int t = std::bit_width(v) * 1233 >> 12;
+  return t + (v >= kPowersOf10[t]);
+}
+
+// Write the decimal_digits(v) digits of v starting at out, two at a time from
+// a 200-byte pair table; returns one past the last digit. No terminator.
+char* write_decimal(uint64_t v, char* out);
+
+// Length of the numbers joined by separator
+size_t formatted_list_size(std::span<const uint64_t> numbers, absl::string_view separator = ", ");
+
+// Write the numbers joined by separator into out and return the bytes written.
+// Throws std::invalid_argument if out is shorter than formatted_list_size.
+size_t format_number_list_to(std::span<const uint64_t> numbers, std::span<char> out,
+                             absl::string_view separator = ", ");
+
+// Append the numbers joined by separator to cord. Long lists are formatted
+// into one exactly sized buffer that the cord adopts as an external chunk,
+// without copying; short ones are copied, as Cord does for small chunks.
+void append_number_list(std::span<const uint64_t> numbers, absl::Cord& cord,
+                        absl::string_view separator = ", ");
+
+}  // namespace ferric
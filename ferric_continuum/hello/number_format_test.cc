@@ -0,0 +1,75 @@
+#include "number_format.hh"
+
+#include "absl/strings/str_join.h"
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+TEST(NumberFormatTest, DecimalDigits) {
+  static_assert(decimal_digits(0) == 1);
+  static_assert(decimal_digits(std::numeric_limits<uint64_t>::max()) == 20);
+  // Both sides of every power of ten
+  for (size_t k = 1; k < kPowersOf10.size(); ++k) {
+    EXPECT_EQ(decimal_digits(kPowersOf10[k] - 1), static_cast<int>(k));
+    EXPECT_EQ(decimal_digits(kPowersOf10[k]), static_cast<int>(k + 1));
+  }
+}
+
+TEST(NumberFormatTest, WriteDecimal) {
+  std::vector<uint64_t> values = {0, 7, 10, 99, 100, 4294967295ULL, 4294967296ULL,
+                                  std::numeric_limits<uint64_t>::max()};
+  for (uint64_t v = 1; v < std::numeric_limits<uint64_t>::max() / 3; v = v * 3 + 1) {
+    values.push_back(v);
+  }
+  for (const uint64_t v : values) {
+    char buffer[20];
+    const char* end = write_decimal(v, buffer);
+    EXPECT_EQ(std::string(buffer, end - buffer), std::to_string(v));
+  }
+}
+
+TEST(NumberFormatTest, FormatIntoBuffer) {
+  const std::vector<uint64_t> numbers = {2, 3, 5, 7, 11, 18446744073709551557ULL};
+  const std::string expected = absl::StrJoin(numbers, ", ");
+  ASSERT_EQ(formatted_list_size(numbers), expected.size());
+
+  std::string buffer(expected.size(), '#');
+  EXPECT_EQ(format_number_list_to(numbers, buffer), expected.size());
+  EXPECT_EQ(buffer, expected);
+
+  std::string short_buffer(expected.size() - 1, '#');
+  EXPECT_THROW(format_number_list_to(numbers, short_buffer), std::invalid_argument);
+
+  std::string lines(formatted_list_size(numbers, "\n"), '#');
+  format_number_list_to(numbers, lines, "\n");
+  EXPECT_EQ(lines, absl::StrJoin(numbers, "\n"));
+
+  EXPECT_EQ(formatted_list_size({}), 0);
+  EXPECT_EQ(format_number_list_to({}, {}), 0);
+}
+
+TEST(NumberFormatTest, AppendToCord) {
+  absl::Cord cord("primes: ");
+  const std::vector<uint64_t> numbers = {2, 3, 5, 7};
+  append_number_list(numbers, cord);
+  EXPECT_EQ(std::string(cord), "primes: 2, 3, 5, 7");
+
+  // Long enough to be handed to the cord as an external chunk
+  std::vector<uint64_t> many(1000);
+  for (size_t i = 0; i < many.size(); ++i) {
+    many[i] = i * 1000003;
+  }
+  absl::Cord long_cord("all: ");
+  append_number_list(many, long_cord, ",");
+  EXPECT_EQ(std::string(long_cord), "all: " + absl::StrJoin(many, ","));
+}
+
+}  // namespace
+}  // namespace ferric
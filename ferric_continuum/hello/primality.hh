@@ -0,0 +1,122 @@
+#pragma once
+
+#include "montgomery.hh"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace ferric {
+
+// Building blocks of is_prime, all usable in constant expressions.
+
+// Primes below 64; above the table, is_prime trial-divides by the odd ones
+inline constexpr std::array<uint32_t, 18> kSmallPrimes = {2,  3,  5,  7,  11, 13, 17, 19, 23,
+                                                          29, 31, 37, 41, 43, 47, 53, 59, 61};
+
+// Every n below this is answered from kSmallPrimeTable
+inline constexpr uint64_t kSmallPrimeTableLimit = uint64_t{1} << 16;
+
+// Odd-only primality bitmap: bit i is set when 2 * i + 1 is prime
+consteval std::array<uint64_t, kSmallPrimeTableLimit / 128> make_small_prime_table() {
+  std::array<uint64_t, kSmallPrimeTableLimit / 128> words{};
+  for (auto& word : words) {
+    word = ~uint64_t{0};
+  }
+  words[0] &= ~uint64_t{1};  // 1 is not prime
+  for (uint64_t p = 3; p * p < kSmallPrimeTableLimit; p += 2) {
+    if (words[p / 128] >> (p / 2 % 64) & 1) {
+      for (uint64_t m = p * p; m < kSmallPrimeTableLimit; m += 2 * p) {
+        words[m / 128] &= ~(uint64_t{1} << (m / 2 % 64));
+      }
+    }
+  }
+  return words;
+}
+
+inline constexpr std::array<uint64_t, kSmallPrimeTableLimit / 128> kSmallPrimeTable =
+    make_small_prime_table();
+
+// Primality of n < kSmallPrimeTableLimit with a single table load
+constexpr bool is_small_prime(uint64_t n) {
+  if (n % 2 == 0) {
+    return n == 2;
+  }
+  return kSmallPrimeTable[n / 128] >> (n / 2 % 64) & 1;
+}
+
+// Divisibility by an odd prime p without hardware division. Multiplying by
+// p^-1 mod 2^64 permutes the 64-bit integers and maps the multiples of p onto
+// exactly [0, (2^64 - 1) / p], so p | n is one multiply and one compare, and
+// the same product is n / p when p does divide n (Granlund-Montgomery).
+struct TrialDivisor {
+  uint64_t p;
+  uint64_t inverse;  // p^-1 mod 2^64, from inverse_mod_2_64 (montgomery.hh)
+  uint64_t limit;    // (2^64 - 1) / p
+
+  constexpr bool divides(uint64_t n) const { return n * inverse <= limit; }
+
+  // n / p, for n a multiple of p
+  constexpr uint64_t exact_quotient(uint64_t n) const { return n * inverse; }
+};
+
+consteval size_t count_odd_primes_below(uint64_t bound) {
+  size_t count = 0;
+  for (uint64_t p = 3; p < bound; p += 2) {
+    count += is_small_prime(p);
+  }
+  return count;
+}
+
+// Divisors for the odd primes below Bound (at most kSmallPrimeTableLimit), in
+// increasing order
+template <uint64_t Bound>
+consteval std::array<TrialDivisor, count_odd_primes_below(Bound)> make_trial_divisors() {
+  static_assert(Bound <= kSmallPrimeTableLimit);
+  std::array<TrialDivisor, count_odd_primes_below(Bound)> divisors{};
+  size_t i = 0;
+  for (uint64_t p = 3; p < Bound; p += 2) {
+    if (is_small_prime(p)) {
+      divisors[i++] = {p, inverse_mod_2_64(p), ~uint64_t{0} / p};
+    }
+  }
+  return divisors;
+}
+
+// The odd entries of kSmallPrimes, for the trial division in is_prime and the
+// SIMD prefilter of is_prime_batch
+inline constexpr auto kSmallPrimeDivisors = make_trial_divisors<64>();
+
+// Bases that make Miller-Rabin deterministic for every n < 2^64 (Jim Sinclair)
+inline constexpr std::array<uint64_t, 7> kMillerRabinBases = {2,      325,     9375,      28178,
+                                                              450775, 9780504, 1795265022};
+
+// Strong probable-prime test of odd n > 2 against each deterministic base
+constexpr bool miller_rabin(uint64_t n) {
+  const Montgomery64 mont(n);
+  const int s = std::countr_zero(n - 1);
+  const uint64_t d = (n - 1) >> s;
+
+  for (uint64_t base : kMillerRabinBases) {
+    const uint64_t a = base % n;
+    if (a == 0) {
+      continue;
+    }
+    uint64_t x = mont.pow(mont.to_montgomery(a), d);
+    if (x == mont.one() || x == mont.minus_one()) {
+      continue;
+    }
+    bool witness = true;
+    for (int r = 1; r < s && witness; ++r) {
+      x = mont.mul(x, x);
+      witness = x != mont.minus_one();
+    }
+    if (witness) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace ferric
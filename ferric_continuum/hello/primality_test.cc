@@ -0,0 +1,61 @@
+#include "primality.hh"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace ferric {
+namespace {
+
+static_assert(is_small_prime(2) && is_small_prime(3) && is_small_prime(65521));
+static_assert(!is_small_prime(0) && !is_small_prime(1) && !is_small_prime(65535));
+static_assert(miller_rabin(1000000007) && !miller_rabin(3215031751ULL));
+static_assert(kSmallPrimeDivisors.size() == 17 && kSmallPrimeDivisors.back().p == 61);
+
+TEST(PrimalityTest, SmallPrimeTableMatchesSieve) {
+  std::vector<bool> composite(kSmallPrimeTableLimit, false);
+  for (uint64_t n = 2; n < kSmallPrimeTableLimit; ++n) {
+    if (!composite[n]) {
+      for (uint64_t m = n * n; m < kSmallPrimeTableLimit; m += n) {
+        composite[m] = true;
+      }
+    }
+    ASSERT_EQ(is_small_prime(n), !composite[n]) << n;
+  }
+  EXPECT_FALSE(is_small_prime(0));
+  EXPECT_FALSE(is_small_prime(1));
+}
+
+TEST(PrimalityTest, MillerRabin) {
+  // Strong pseudoprimes to several small bases
+  for (uint64_t n : {2047ULL, 3215031751ULL, 4759123141ULL, 3825123056546413051ULL}) {
+    EXPECT_FALSE(miller_rabin(n)) << n;
+  }
+  for (uint64_t p : {65537ULL, 1000000007ULL, 4294967291ULL, 18446744073709551557ULL}) {
+    EXPECT_TRUE(miller_rabin(p)) << p;
+  }
+}
+
+TEST(PrimalityTest, TrialDivisorsMatchDivision) {
+  constexpr auto divisors = make_trial_divisors<1024>();
+  EXPECT_EQ(divisors.size(), 171);
+  const std::vector<uint64_t> samples = {0, 1, 2, 3, 1000, 1001, 65535, 4294967295, ~0ULL,
+                                         ~0ULL - 1, ~0ULL / 3, ~0ULL / 3 + 1, 1ULL << 63,
+                                         999999999989ULL * 1021};
+  for (const TrialDivisor& d : divisors) {
+    EXPECT_EQ(d.p * d.inverse, 1);
+    std::vector<uint64_t> ns = samples;
+    // Multiples of p at the top of the range, and their neighbours
+    const uint64_t top = ~0ULL / d.p * d.p;
+    ns.insert(ns.end(), {top, top - 1, top + 1, top - d.p, d.p, d.p - 1, d.p + 1});
+    for (const uint64_t n : ns) {
+      ASSERT_EQ(d.divides(n), n % d.p == 0) << n << " " << d.p;
+      if (n % d.p == 0) {
+        ASSERT_EQ(d.exact_quotient(n), n / d.p) << n << " " << d.p;
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace ferric
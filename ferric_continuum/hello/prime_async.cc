@@ -0,0 +1,137 @@
+#include "prime_async.hh"
+
+#include "prime_sieve.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <utility>
+
+namespace ferric {
+
+namespace {
+
+// State shared by the tasks of one primes_up_to_async call
+struct SieveJob {
+  uint64_t lo = 0;
+  uint64_t hi = 0;
+  std::vector<std::pair<uint64_t, uint64_t>> chunks;
+  std::shared_ptr<const std::vector<uint32_t>> sieving;
+  std::vector<std::vector<uint64_t>> parts;  // Primes of each chunk
+  StopToken stop;
+  PrimeProgressCallback progress;
+
+  std::atomic<size_t> remaining = 0;  // Chunks still running; the last one finishes the job
+  std::atomic<bool> cancelled = false;
+
+  std::mutex mutex;  // Serializes progress callbacks and guards the fields below
+  uint64_t done = 0;
+  std::exception_ptr error;
+
+  std::promise<std::vector<uint64_t>> promise;
+
+  void report(uint64_t numbers) {
+    if (!progress || numbers == 0) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    done += numbers;
+    progress(PrimeProgress{done, hi - lo});
+  }
+
+  void run_chunk(size_t c);
+  void finish();
+};
+
+void SieveJob::run_chunk(size_t c) {
+  const auto [chunk_lo, chunk_hi] = chunks[c];
+  try {
+    uint64_t reported = chunk_lo;
+    SegmentedSieve sieve(chunk_lo, chunk_hi, sieving);
+    while (true) {
+      if (stop.stop_requested()) {
+        cancelled.store(true, std::memory_order_relaxed);
+        break;
+      }
+      if (!sieve.next_segment()) {
+        report(chunk_hi - reported);
+        break;
+      }
+      sieve.for_each_prime([&](uint64_t p) { parts[c].push_back(p); });
+      const uint64_t end = std::min(sieve.segment_end(), chunk_hi);
+      report(end - reported);
+      reported = end;
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!error) {
+      error = std::current_exception();
+    }
+  }
+  // acq_rel: the last chunk sees every other chunk's parts
+  if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    finish();
+  }
+}
+
+void SieveJob::finish() {
+  if (error) {
+    promise.set_exception(error);
+    return;
+  }
+  if (cancelled.load(std::memory_order_relaxed)) {
+    promise.set_exception(std::make_exception_ptr(OperationCancelled()));
+    return;
+  }
+  try {
+    size_t count = 0;
+    for (const auto& part : parts) {
+      count += part.size();
+    }
+    std::vector<uint64_t> result(count);
+    uint64_t* out = result.data();
+    for (auto& part : parts) {
+      if (!part.empty()) {
+        std::memcpy(out, part.data(), part.size() * sizeof(uint64_t));
+        out += part.size();
+      }
+      std::vector<uint64_t>().swap(part);
+    }
+    promise.set_value(std::move(result));
+  } catch (...) {
+    promise.set_exception(std::current_exception());
+  }
+}
+
+}  // namespace
+
+std::future<std::vector<uint64_t>> primes_up_to_async(uint64_t n, ThreadPool& executor,
+                                                      StopToken stop,
+                                                      PrimeProgressCallback progress) {
+  auto job = std::make_shared<SieveJob>();
+  auto result = job->promise.get_future();
+  if (n < 2) {
+    job->promise.set_value({});
+    return result;
+  }
+  job->lo = 2;
+  job->hi = n == std::numeric_limits<uint64_t>::max() ? n : n + 1;
+  job->stop = std::move(stop);
+  job->progress = std::move(progress);
+
+  // Sieving primes are found up front; everything else runs on the executor
+  auto plan = plan_parallel_sieve(job->lo, job->hi, executor.size());
+  job->chunks = std::move(plan.chunks);
+  job->sieving = std::move(plan.primes);
+  job->parts.resize(job->chunks.size());
+  job->remaining.store(job->chunks.size(), std::memory_order_relaxed);
+
+  for (size_t c = 0; c < job->chunks.size(); ++c) {
+    executor.submit([job, c] { job->run_chunk(c); });
+  }
+  return result;
+}
+
+}  // namespace ferric
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "thread_pool.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace ferric {
+
+// Cooperative cancellation, shaped like std::stop_source / std::stop_token,
+// which libc++ 18 still ships only as an experimental feature. A default
+// StopToken never reports a stop.
+class StopToken {
+ public:
+  StopToken() = default;
+
+  bool stop_requested() const {
+    return state_ != nullptr && state_->load(std::memory_order_relaxed);
+  }
+
+ private:
+  friend class StopSource;
+  explicit StopToken(std::shared_ptr<const std::atomic<bool>> state) : state_(std::move(state)) {}
+
+  std::shared_ptr<const std::atomic<bool>> state_;
+};
+
+class StopSource {
+ public:
+  StopSource() : state_(std::make_shared<std::atomic<bool>>(false)) {}
+
+  void request_stop() { state_->store(true, std::memory_order_relaxed); }
+  bool stop_requested() const { return state_->load(std::memory_order_relaxed); }
+  StopToken token() const { return StopToken(state_); }
+
+ private:
+  std::shared_ptr<std::atomic<bool>> state_;
+};
+
+// Thrown through the future of a computation that stopped on request
+class OperationCancelled : public std::runtime_error {
+ public:
+  OperationCancelled() : std::runtime_error("operation cancelled") {}
+};
+
+// How many of the total numbers in [2, n] have been sieved. done only grows,
+// and reaches total just before the result is published.
+struct PrimeProgress {
+  uint64_t done = 0;
+  uint64_t total = 0;
+};
+
+// Called once per sieved segment. Calls are serialized but come from the
+// executor's worker threads, and hold up that worker, so keep them short.
+using PrimeProgressCallback = std::function<void(const PrimeProgress&)>;
+
+// primes_up_to(n), computed on executor without blocking the caller.
+//
+// The range is split into chunks that run as independent tasks; the task that
+// finishes last concatenates their primes and fulfils the future, so no worker
+// ever waits on another and a pool of any size makes progress. Every task
+// checks stop between sieve segments, so a stop request abandons the work
+// within about one segment per running task and the future then throws
+// OperationCancelled. executor must outlive the computation.
+std::future<std::vector<uint64_t>> primes_up_to_async(uint64_t n, ThreadPool& executor,
+                                                      StopToken stop = {},
+                                                      PrimeProgressCallback progress = {});
+
+}  // namespace ferric
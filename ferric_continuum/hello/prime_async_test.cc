@@ -0,0 +1,79 @@
+#include "prime_async.hh"
+
+#include "hello_lib.hh"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+using namespace std::chrono_literals;
+
+TEST(PrimesUpToAsyncTest, MatchesPrimesUpTo) {
+  ThreadPool pool(4);
+  for (const uint64_t n : {0, 1, 2, 3, 100, 65536, 1000003, 10000000}) {
+    EXPECT_EQ(primes_up_to_async(n, pool).get(), primes_up_to(n)) << n;
+  }
+}
+
+TEST(PrimesUpToAsyncTest, RunsOnASingleWorker) {
+  // Chunks never wait on each other, so one worker is enough
+  ThreadPool pool(1);
+  auto first = primes_up_to_async(2000000, pool);
+  auto second = primes_up_to_async(3000000, pool);
+  EXPECT_EQ(first.get(), primes_up_to(2000000));
+  EXPECT_EQ(second.get(), primes_up_to(3000000));
+}
+
+TEST(PrimesUpToAsyncTest, ReportsProgress) {
+  ThreadPool pool(4);
+  constexpr uint64_t kN = 20000000;
+  std::mutex mutex;
+  std::vector<PrimeProgress> reports;
+  const auto primes = primes_up_to_async(kN, pool, {}, [&](const PrimeProgress& progress) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        reports.push_back(progress);
+                      }).get();
+  EXPECT_EQ(primes.size(), 1270607);
+  ASSERT_GT(reports.size(), 1);
+  for (size_t i = 0; i < reports.size(); ++i) {
+    EXPECT_EQ(reports[i].total, kN - 1);
+    if (i > 0) {
+      EXPECT_GT(reports[i].done, reports[i - 1].done);
+    }
+  }
+  EXPECT_EQ(reports.back().done, kN - 1);
+}
+
+TEST(PrimesUpToAsyncTest, StopsOnRequest) {
+  ThreadPool pool(2);
+  StopSource source;
+  // Far more work than the test would wait for; stop once it is under way
+  auto primes = primes_up_to_async(uint64_t{1} << 40, pool, source.token(),
+                                   [&](const PrimeProgress&) { source.request_stop(); });
+  ASSERT_EQ(primes.wait_for(10s), std::future_status::ready);
+  EXPECT_THROW(primes.get(), OperationCancelled);
+
+  // A stop that was requested up front cancels before any sieving
+  EXPECT_THROW(primes_up_to_async(1000000, pool, source.token()).get(), OperationCancelled);
+
+  // The pool is free for the next request
+  EXPECT_EQ(primes_up_to_async(1000, pool).get(), primes_up_to(1000));
+}
+
+TEST(StopSourceTest, Tokens) {
+  EXPECT_FALSE(StopToken().stop_requested());
+  StopSource source;
+  const StopToken token = source.token();
+  EXPECT_FALSE(token.stop_requested());
+  source.request_stop();
+  EXPECT_TRUE(source.stop_requested());
+  EXPECT_TRUE(token.stop_requested());
+}
+
+}  // namespace
+}  // namespace ferric
@@ -0,0 +1,81 @@
+#include "prime_cache.hh"
+
+#include "prime_sieve.hh"
+
+#include <bit>
+#include <limits>
+
+namespace ferric {
+
+namespace {
+
+// Chunk index and offset of element i when chunk k holds first << k elements
+struct Slot {
+  size_t chunk;
+  size_t offset;
+};
+
+Slot slot_of(size_t i, size_t first) {
+  const size_t chunk = std::bit_width(i / first + 1) - 1;
+  return {chunk, i - first * ((size_t{1} << chunk) - 1)};
+}
+
+}  // namespace
+
+std::vector<uint64_t> PrimeCache::primes_up_to(uint64_t n) {
+  if (bound() < n) {
+    extend(n);
+  }
+  // Every prime published after this load is above the bound seen, hence above n
+  const size_t count = size();
+  size_t lo = 0;
+  size_t hi = count;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (at(mid) <= n) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  std::vector<uint64_t> primes;
+  primes.reserve(lo);
+  for (size_t i = 0; i < lo; ++i) {
+    primes.push_back(at(i));
+  }
+  return primes;
+}
+
+void PrimeCache::extend(uint64_t n) {
+  std::lock_guard<std::mutex> lock(extend_mutex_);
+  const uint64_t from = bound_.load(std::memory_order_relaxed) + 1;
+  if (from > n) {
+    return;  // Another writer got there first
+  }
+  // Drop anything an earlier, failed extension appended without publishing
+  written_ = count_.load(std::memory_order_relaxed);
+  const uint64_t hi = n == std::numeric_limits<uint64_t>::max() ? n : n + 1;
+  SegmentedSieve sieve(from, hi);
+  while (sieve.next_segment()) {
+    sieve.for_each_prime([&](uint64_t p) { append(p); });
+  }
+  // Count first: a reader that sees the new bound must also see its primes
+  count_.store(written_, std::memory_order_release);
+  bound_.store(n, std::memory_order_release);
+}
+
+void PrimeCache::append(uint64_t p) {
+  const Slot slot = slot_of(written_, kFirstChunk);
+  if (!chunks_[slot.chunk]) {
+    chunks_[slot.chunk] = std::make_unique<uint64_t[]>(kFirstChunk << slot.chunk);
+  }
+  chunks_[slot.chunk][slot.offset] = p;
+  ++written_;
+}
+
+uint64_t PrimeCache::at(size_t i) const {
+  const Slot slot = slot_of(i, kFirstChunk);
+  return chunks_[slot.chunk][slot.offset];
+}
+
+}  // namespace ferric
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ferric {
+
+// Thread-safe, incrementally extended cache of the primes up to some bound.
+//
+// A request above the cached bound sieves only the missing tail [bound + 1, n]
+// and appends it. Primes are stored in chunks that never move once written,
+// and a new tail is published with a release store of the count, so requests
+// within the cached prefix never take a lock, even while another thread is
+// extending the cache.
+class PrimeCache {
+ public:
+  PrimeCache() = default;
+
+  PrimeCache(const PrimeCache&) = delete;
+  PrimeCache& operator=(const PrimeCache&) = delete;
+
+  // All primes <= n, sieving whatever part lies above the cached bound
+  std::vector<uint64_t> primes_up_to(uint64_t n);
+
+  // Largest n whose primes are all cached
+  uint64_t bound() const { return bound_.load(std::memory_order_acquire); }
+
+  // Number of cached primes
+  size_t size() const { return count_.load(std::memory_order_acquire); }
+
+ private:
+  // Chunk k holds kFirstChunk << k primes, so 48 chunks outgrow any uint64 range
+  static constexpr size_t kFirstChunk = size_t{1} << 12;
+  static constexpr size_t kMaxChunks = 48;
+
+  void extend(uint64_t n);
+  void append(uint64_t p);
+  uint64_t at(size_t i) const;
+
+  std::mutex extend_mutex_;  // Serializes writers only
+  std::array<std::unique_ptr<uint64_t[]>, kMaxChunks> chunks_;
+  size_t written_ = 0;  // Primes appended by the writer, published or not
+  std::atomic<size_t> count_ = 0;
+  std::atomic<uint64_t> bound_ = 1;
+};
+
+}  // namespace ferric
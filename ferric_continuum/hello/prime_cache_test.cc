@@ -0,0 +1,72 @@
+#include "prime_cache.hh"
+
+#include "prime_sieve.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+std::vector<uint64_t> reference_primes(uint64_t n) {
+  std::vector<uint64_t> primes;
+  for (uint64_t p : PrimeRange(0, n + 1)) {
+    primes.push_back(p);
+  }
+  return primes;
+}
+
+TEST(PrimeCacheTest, StartsEmpty) {
+  PrimeCache cache;
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_TRUE(cache.primes_up_to(1).empty());
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(PrimeCacheTest, GrowsOnlyWhenAskedForMore) {
+  PrimeCache cache;
+  EXPECT_EQ(cache.primes_up_to(20), std::vector<uint64_t>({2, 3, 5, 7, 11, 13, 17, 19}));
+  EXPECT_EQ(cache.bound(), 20);
+
+  EXPECT_EQ(cache.primes_up_to(1000000), reference_primes(1000000));
+  EXPECT_EQ(cache.bound(), 1000000);
+  EXPECT_EQ(cache.size(), 78498);
+
+  // Smaller requests are served from the prefix without growing the cache
+  EXPECT_EQ(cache.primes_up_to(10), std::vector<uint64_t>({2, 3, 5, 7}));
+  EXPECT_EQ(cache.primes_up_to(999983).back(), 999983);
+  EXPECT_EQ(cache.bound(), 1000000);
+
+  // Growth spans several storage chunks
+  EXPECT_EQ(cache.primes_up_to(5000000), reference_primes(5000000));
+}
+
+TEST(PrimeCacheTest, ConcurrentReadersAndWriters) {
+  PrimeCache cache;
+  const auto expected = reference_primes(4000000);
+  std::vector<std::thread> threads;
+  std::vector<int> mismatches(8, 0);
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t] {
+      for (uint64_t n = 1000 * (t + 1); n <= 4000000; n = n * 3 / 2 + t) {
+        const auto primes = cache.primes_up_to(n);
+        const auto end = std::upper_bound(expected.begin(), expected.end(), n);
+        if (!std::equal(primes.begin(), primes.end(), expected.begin(), end)) {
+          ++mismatches[t];
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < 8; ++t) {
+    EXPECT_EQ(mismatches[t], 0) << "thread " << t;
+  }
+}
+
+}  // namespace
+}  // namespace ferric
@@ -0,0 +1,413 @@
+#include "prime_service.hh"
+
+#include "hello_lib.hh"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+namespace ferric {
+
+namespace {
+
+// Larger frames are rejected rather than allocated
+constexpr uint32_t kMaxFrameBytes = uint32_t{1} << 26;
+
+// Pause after an accept error other than EINTR or ECONNABORTED, doubling
+// while the error persists
+constexpr std::chrono::milliseconds kMinAcceptBackoff{1};
+constexpr std::chrono::milliseconds kMaxAcceptBackoff{1000};
+
+[[noreturn]] void throw_socket_error(const std::string& what) {
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+sockaddr_un socket_address(const std::string& path) {
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    throw std::runtime_error("prime service: socket path is too long: " + path);
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return addr;
+}
+
+// false on end of stream before the first byte
+bool read_exact(int fd, char* data, size_t bytes) {
+  size_t done = 0;
+  while (done < bytes) {
+    const ssize_t n = ::read(fd, data + done, bytes - done);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw_socket_error("prime service: cannot read");
+    }
+    if (n == 0) {
+      if (done == 0) {
+        return false;
+      }
+      throw std::runtime_error("prime service: connection closed mid-frame");
+    }
+    done += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+void write_exact(int fd, const char* data, size_t bytes) {
+  while (bytes > 0) {
+    // MSG_NOSIGNAL: a vanished peer is an error here, not a SIGPIPE
+    const ssize_t n = ::send(fd, data, bytes, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw_socket_error("prime service: cannot write");
+    }
+    data += n;
+    bytes -= static_cast<size_t>(n);
+  }
+}
+
+}  // namespace
+
+bool read_frame(int fd, std::string& payload) {
+  unsigned char header[4];
+  if (!read_exact(fd, reinterpret_cast<char*>(header), sizeof(header))) {
+    return false;
+  }
+  const uint32_t length = header[0] | header[1] << 8 | header[2] << 16 |
+                          static_cast<uint32_t>(header[3]) << 24;
+  if (length > kMaxFrameBytes) {
+    throw std::runtime_error("prime service: frame exceeds the size limit");
+  }
+  payload.resize(length);
+  if (length > 0 && !read_exact(fd, payload.data(), length)) {
+    throw std::runtime_error("prime service: connection closed mid-frame");
+  }
+  return true;
+}
+
+void write_frame(int fd, const std::string& payload) {
+  if (payload.size() > kMaxFrameBytes) {
+    throw std::runtime_error("prime service: frame exceeds the size limit");
+  }
+  const uint32_t length = static_cast<uint32_t>(payload.size());
+  const unsigned char header[4] = {static_cast<unsigned char>(length),
+                                   static_cast<unsigned char>(length >> 8),
+                                   static_cast<unsigned char>(length >> 16),
+                                   static_cast<unsigned char>(length >> 24)};
+  write_exact(fd, reinterpret_cast<const char*>(header), sizeof(header));
+  write_exact(fd, payload.data(), payload.size());
+}
+
+int LatencyHistogram::bucket(uint64_t ns) {
+  if (ns < kSubBuckets) {
+    return static_cast<int>(ns);
+  }
+  // Exponent, then the two bits below the leading one
+  const int e = std::bit_width(ns) - 1;
+  const int sub = static_cast<int>(ns >> (e - 2)) & (kSubBuckets - 1);
+  return (e - 1) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(int b) {
+  if (b < kSubBuckets) {
+    return static_cast<uint64_t>(b);
+  }
+  const int e = b / kSubBuckets + 1;
+  const uint64_t sub = b % kSubBuckets;
+  return ((kSubBuckets + sub + 1) << (e - 2)) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+  const uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+  buckets_[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds LatencyHistogram::quantile(double q) const {
+  const uint64_t total = count();
+  if (total == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  // Rank of the sample at quantile q, 1-based
+  const uint64_t rank =
+      std::max<uint64_t>(1, static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * total + 0.5));
+  uint64_t seen = 0;
+  for (int b = 0; b < kBuckets; ++b) {
+    seen += buckets_[b].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::chrono::nanoseconds(bucket_upper_bound(b));
+    }
+  }
+  // Counts raced ahead of the buckets being summed
+  return std::chrono::nanoseconds(bucket_upper_bound(kBuckets - 1));
+}
+
+PrimeService::PrimeService() : PrimeService(Options()) {}
+
+PrimeService::PrimeService(Options options)
+    : options_(options),
+      is_prime_batcher_(
+          [](std::span<const uint64_t> in, std::span<uint8_t> out) { is_prime_batch(in, out); },
+          options.max_batch, options.max_delay),
+      fibonacci_batcher_(
+          [](std::span<const int> in, std::span<uint64_t> out) { fibonacci_batch(in, out); },
+          options.max_batch, options.max_delay) {}
+
+PrimeResponse PrimeService::handle(const PrimeRequest& request) {
+  const auto start = std::chrono::steady_clock::now();
+  PrimeResponse response;
+  try {
+    response = dispatch(request);
+  } catch (const std::exception& e) {
+    response.set_error(e.what());
+  }
+  response.set_id(request.id());
+  requests_.fetch_add(1, std::memory_order_relaxed);
+  latency_.record(std::chrono::steady_clock::now() - start);
+  return response;
+}
+
+PrimeResponse PrimeService::dispatch(const PrimeRequest& request) {
+  PrimeResponse response;
+  switch (request.query_case()) {
+    case PrimeRequest::kIsPrime: {
+      const auto& ns = request.is_prime().n();
+      const std::vector<uint8_t> prime =
+          is_prime_batcher_.run(std::span<const uint64_t>(ns.data(), ns.size()));
+      auto* result = response.mutable_is_prime();
+      result->mutable_prime()->Reserve(static_cast<int>(prime.size()));
+      for (const uint8_t p : prime) {
+        result->add_prime(p != 0);
+      }
+      break;
+    }
+    case PrimeRequest::kPrimesUpTo: {
+      const uint64_t n = request.primes_up_to().n();
+      if (n > options_.max_primes_up_to) {
+        response.set_error("primes_up_to: n exceeds the service limit of " +
+                           std::to_string(options_.max_primes_up_to));
+        break;
+      }
+      const std::vector<uint64_t> primes = cache_.primes_up_to(n);
+      response.mutable_primes_up_to()->mutable_primes()->Add(primes.begin(), primes.end());
+      break;
+    }
+    case PrimeRequest::kFibonacci: {
+      const auto& ns = request.fibonacci().n();
+      // Checked here so one bad index fails only its own request, not the batch
+      for (const int n : ns) {
+        if (n < 0 || n > kMaxFibonacci) {
+          response.set_error("fibonacci: n must be in [0, 93] to fit in uint64_t");
+          return response;
+        }
+      }
+      const std::vector<uint64_t> values =
+          fibonacci_batcher_.run(std::span<const int>(ns.data(), ns.size()));
+      response.mutable_fibonacci()->mutable_value()->Add(values.begin(), values.end());
+      break;
+    }
+    case PrimeRequest::kStats:
+      *response.mutable_stats() = stats();
+      break;
+    case PrimeRequest::QUERY_NOT_SET:
+      response.set_error("request has no query");
+      break;
+  }
+  return response;
+}
+
+ServiceStats PrimeService::stats() const {
+  ServiceStats stats;
+  stats.set_requests(requests_.load(std::memory_order_relaxed));
+  stats.set_batches(is_prime_batcher_.batches() + fibonacci_batcher_.batches());
+  stats.set_batched_requests(is_prime_batcher_.calls() + fibonacci_batcher_.calls());
+  stats.set_latency_p50_ns(latency_.quantile(0.50).count());
+  stats.set_latency_p99_ns(latency_.quantile(0.99).count());
+  stats.set_cached_prime_bound(cache_.bound());
+  return stats;
+}
+
+PrimeServer::PrimeServer(PrimeService& service, std::string path)
+    : service_(service), path_(std::move(path)) {
+  const sockaddr_un addr = socket_address(path_);
+  listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    throw_socket_error("PrimeServer: cannot create socket");
+  }
+  ::unlink(path_.c_str());
+  if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(listen_fd_, SOMAXCONN) != 0) {
+    const int saved = errno;
+    ::close(listen_fd_);
+    errno = saved;
+    throw_socket_error("PrimeServer: cannot listen on " + path_);
+  }
+  acceptor_ = std::thread([this] { accept_loop(); });
+}
+
+PrimeServer::~PrimeServer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    // shutdown() wakes threads blocked in accept() and read()
+    ::shutdown(listen_fd_, SHUT_RDWR);
+    for (const Connection& connection : connections_) {
+      if (!connection.done) {
+        ::shutdown(connection.fd, SHUT_RDWR);
+      }
+    }
+  }
+  stopped_.notify_all();
+  acceptor_.join();
+  for (Connection& connection : connections_) {
+    connection.thread.join();
+  }
+  ::close(listen_fd_);
+  ::unlink(path_.c_str());
+}
+
+void PrimeServer::accept_loop() {
+  std::chrono::milliseconds backoff = kMinAcceptBackoff;
+  while (true) {
+    const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    const int error = fd < 0 ? errno : 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+      return;
+    }
+    if (fd < 0) {
+      if (error == EINTR || error == ECONNABORTED) {
+        continue;  // Interrupted, or a connection that was reset before it was accepted
+      }
+      // Out of descriptors or buffers: accepting again right away would only
+      // spin, so back off until descriptors free up (shutdown cuts this short)
+      stopped_.wait_for(lock, backoff, [this] { return stopping_; });
+      backoff = std::min(backoff * 2, kMaxAcceptBackoff);
+      continue;
+    }
+    backoff = kMinAcceptBackoff;
+    // Reap threads of connections that have closed since the last accept
+    for (auto it = connections_.begin(); it != connections_.end();) {
+      if (it->done) {
+        it->thread.join();
+        it = connections_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    Connection& connection = connections_.emplace_back();
+    connection.fd = fd;
+    connection.thread = std::thread([this, &connection] { serve_connection(connection); });
+  }
+}
+
+void PrimeServer::serve_connection(Connection& connection) {
+  std::string payload;
+  PrimeRequest request;
+  try {
+    while (read_frame(connection.fd, payload)) {
+      PrimeResponse response;
+      if (request.ParseFromString(payload)) {
+        response = service_.handle(request);
+      } else {
+        response.set_error("malformed request");
+      }
+      write_frame(connection.fd, response.SerializeAsString());
+    }
+  } catch (const std::exception&) {
+    // The peer went away or sent garbage framing; drop just this connection
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  ::close(connection.fd);
+  connection.done = true;
+}
+
+PrimeServiceClient::PrimeServiceClient(const std::string& path) {
+  const sockaddr_un addr = socket_address(path);
+  fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd_ < 0) {
+    throw_socket_error("PrimeServiceClient: cannot create socket");
+  }
+  if (::connect(fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+    const int saved = errno;
+    ::close(fd_);
+    errno = saved;
+    throw_socket_error("PrimeServiceClient: cannot connect to " + path);
+  }
+}
+
+PrimeServiceClient::~PrimeServiceClient() {
+  ::close(fd_);
+}
+
+PrimeResponse PrimeServiceClient::call(const PrimeRequest& request) {
+  write_frame(fd_, request.SerializeAsString());
+  std::string payload;
+  if (!read_frame(fd_, payload)) {
+    throw std::runtime_error("PrimeServiceClient: server closed the connection");
+  }
+  PrimeResponse response;
+  if (!response.ParseFromString(payload)) {
+    throw std::runtime_error("PrimeServiceClient: malformed response");
+  }
+  return response;
+}
+
+PrimeResponse PrimeServiceClient::checked_call(const PrimeRequest& request) {
+  PrimeResponse response = call(request);
+  if (response.result_case() == PrimeResponse::kError) {
+    throw std::runtime_error("PrimeServiceClient: " + response.error());
+  }
+  return response;
+}
+
+std::vector<bool> PrimeServiceClient::is_prime(const std::vector<uint64_t>& ns) {
+  PrimeRequest request;
+  request.set_id(next_id_++);
+  request.mutable_is_prime()->mutable_n()->Add(ns.begin(), ns.end());
+  const PrimeResponse response = checked_call(request);
+  const auto& prime = response.is_prime().prime();
+  return std::vector<bool>(prime.begin(), prime.end());
+}
+
+std::vector<uint64_t> PrimeServiceClient::primes_up_to(uint64_t n) {
+  PrimeRequest request;
+  request.set_id(next_id_++);
+  request.mutable_primes_up_to()->set_n(n);
+  const PrimeResponse response = checked_call(request);
+  const auto& primes = response.primes_up_to().primes();
+  return std::vector<uint64_t>(primes.begin(), primes.end());
+}
+
+std::vector<uint64_t> PrimeServiceClient::fibonacci(const std::vector<int>& ns) {
+  PrimeRequest request;
+  request.set_id(next_id_++);
+  request.mutable_fibonacci()->mutable_n()->Add(ns.begin(), ns.end());
+  const PrimeResponse response = checked_call(request);
+  const auto& values = response.fibonacci().value();
+  return std::vector<uint64_t>(values.begin(), values.end());
+}
+
+ServiceStats PrimeServiceClient::stats() {
+  PrimeRequest request;
+  request.set_id(next_id_++);
+  request.mutable_stats();
+  return checked_call(request).stats();
+}
+
+}  // namespace ferric
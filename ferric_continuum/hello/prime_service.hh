@@ -0,0 +1,148 @@
+#pragma once
+
+#include "ferric_continuum/hello/prime_service.pb.h"
+#include "micro_batcher.hh"
+#include "prime_cache.hh"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ferric {
+
+// Latency distribution in log-linear buckets: four per power of two, so any
+// reported quantile is within 25% of the true value. Recording is lock-free.
+class LatencyHistogram {
+ public:
+  void record(std::chrono::nanoseconds latency);
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+  // Upper bound of the bucket holding quantile q in [0, 1]; zero when empty
+  std::chrono::nanoseconds quantile(double q) const;
+
+ private:
+  static constexpr int kSubBuckets = 4;
+  static constexpr int kBuckets = 64 * kSubBuckets;
+
+  static int bucket(uint64_t ns);
+  static uint64_t bucket_upper_bound(int b);
+
+  std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+  std::atomic<uint64_t> count_ = 0;
+};
+
+// Shared, in-process backend of the prime service.
+//
+// is_prime and fibonacci queries from concurrent callers are coalesced by
+// MicroBatchers into single is_prime_batch / fibonacci_batch calls.
+// primes_up_to queries are served from a PrimeCache that stays warm for the
+// life of the service, so only the first caller to reach a bound sieves it.
+// handle() is thread-safe and never throws for bad queries: they come back
+// as PrimeResponse::error.
+class PrimeService {
+ public:
+  struct Options {
+    size_t max_batch = 4096;                   // Inputs per kernel call
+    std::chrono::microseconds max_delay{200};  // Longest a query waits for company
+    uint64_t max_primes_up_to = 100000000;     // Largest n for primes_up_to
+  };
+
+  PrimeService();
+  explicit PrimeService(Options options);
+
+  PrimeResponse handle(const PrimeRequest& request);
+
+  ServiceStats stats() const;
+
+ private:
+  PrimeResponse dispatch(const PrimeRequest& request);
+
+  Options options_;
+  PrimeCache cache_;
+  MicroBatcher<uint64_t, uint8_t> is_prime_batcher_;
+  MicroBatcher<int, uint64_t> fibonacci_batcher_;
+  std::atomic<uint64_t> requests_ = 0;
+  LatencyHistogram latency_;
+};
+
+// Serves a PrimeService on a Unix-domain stream socket. Every connection gets
+// a thread that answers framed requests in order, so concurrency comes from
+// clients opening several connections; their queries meet in the service's
+// batchers.
+class PrimeServer {
+ public:
+  // Binds and listens on path, replacing a stale socket file. Throws
+  // std::runtime_error if the socket cannot be set up.
+  PrimeServer(PrimeService& service, std::string path);
+
+  // Closes the listener and every connection, then joins their threads
+  ~PrimeServer();
+
+  PrimeServer(const PrimeServer&) = delete;
+  PrimeServer& operator=(const PrimeServer&) = delete;
+
+  const std::string& path() const { return path_; }
+
+ private:
+  struct Connection {
+    int fd = -1;
+    bool done = false;  // fd is closed and the thread is about to exit
+    std::thread thread;
+  };
+
+  void accept_loop();
+  void serve_connection(Connection& connection);
+
+  PrimeService& service_;
+  std::string path_;
+  int listen_fd_ = -1;
+
+  std::mutex mutex_;
+  std::condition_variable stopped_;  // Cuts short the acceptor's backoff after an error
+  bool stopping_ = false;
+  std::list<Connection> connections_;  // Stable addresses for the threads serving them
+  std::thread acceptor_;
+};
+
+// Blocking client for one connection to a PrimeServer. Not thread-safe; open
+// one client per thread.
+class PrimeServiceClient {
+ public:
+  // Throws std::runtime_error if path cannot be connected to
+  explicit PrimeServiceClient(const std::string& path);
+  ~PrimeServiceClient();
+
+  PrimeServiceClient(const PrimeServiceClient&) = delete;
+  PrimeServiceClient& operator=(const PrimeServiceClient&) = delete;
+
+  // One round trip. Throws std::runtime_error if the connection fails.
+  PrimeResponse call(const PrimeRequest& request);
+
+  // Typed wrappers; a PrimeResponse::error is thrown as std::runtime_error
+  std::vector<bool> is_prime(const std::vector<uint64_t>& ns);
+  std::vector<uint64_t> primes_up_to(uint64_t n);
+  std::vector<uint64_t> fibonacci(const std::vector<int>& ns);
+  ServiceStats stats();
+
+ private:
+  PrimeResponse checked_call(const PrimeRequest& request);
+
+  int fd_ = -1;
+  uint64_t next_id_ = 1;
+};
+
+// Frame I/O shared by server and client: a 4-byte little-endian length, then
+// the message. read_frame returns false on a clean end of stream before a
+// frame starts; both throw std::runtime_error on errors or oversized frames.
+bool read_frame(int fd, std::string& payload);
+void write_frame(int fd, const std::string& payload);
+
+}  // namespace ferric
@@ -0,0 +1,46 @@
+#include "absl/log/globals.h"
+#include "absl/log/initialize.h"
+#include "absl/log/log.h"
+
+#include "prime_service.hh"
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <exception>
+
+// Serves a PrimeService on a Unix-domain socket until SIGINT or SIGTERM.
+// Usage: prime_service [socket_path]
+int main(int argc, char** argv) {
+  absl::InitializeLog();
+  absl::SetStderrThreshold(absl::LogSeverityAtLeast::kInfo);
+
+  const char* path = argc > 1 ? argv[1] : "/tmp/ferric_prime_service.sock";
+
+  // Block the shutdown signals before any thread starts, so every thread
+  // inherits the mask and sigwait below is the only one to see them
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  try {
+    ferric::PrimeService service;
+    ferric::PrimeServer server(service, path);
+    LOG(INFO) << "Serving on " << server.path();
+
+    int signal = 0;
+    sigwait(&signals, &signal);
+    LOG(INFO) << "Shutting down on signal " << signal;
+
+    const ferric::ServiceStats stats = service.stats();
+    LOG(INFO) << stats.requests() << " requests, " << stats.batched_requests()
+              << " batched into " << stats.batches() << " kernel calls, p50 "
+              << stats.latency_p50_ns() << " ns, p99 " << stats.latency_p99_ns() << " ns";
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+    return 1;
+  }
+  return 0;
+}
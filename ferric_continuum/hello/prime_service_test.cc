@@ -0,0 +1,144 @@
+#include "prime_service.hh"
+
+#include "hello_lib.hh"
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+using namespace std::chrono_literals;
+
+// Short enough for sockaddr_un wherever the test runner puts its temp dir
+std::string socket_path() {
+  return "/tmp/ferric_prime_service_test_" + std::to_string(::getpid()) + ".sock";
+}
+
+TEST(LatencyHistogramTest, Quantiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.quantile(0.5), 0ns);
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.record(std::chrono::microseconds(i));
+  }
+  EXPECT_EQ(histogram.count(), 1000);
+  // Each reported value bounds the true one from above, within 25%
+  const auto p50 = histogram.quantile(0.50);
+  const auto p99 = histogram.quantile(0.99);
+  EXPECT_GE(p50, 500us);
+  EXPECT_LE(p50, 625us);
+  EXPECT_GE(p99, 990us);
+  EXPECT_LE(p99, 1238us);
+  EXPECT_LE(histogram.quantile(0.0), 1250ns);
+}
+
+TEST(PrimeServiceTest, HandlesEachQuery) {
+  PrimeService service;
+  PrimeRequest request;
+  request.set_id(7);
+  for (const uint64_t n : {1, 2, 91, 97, 1000000007}) {
+    request.mutable_is_prime()->add_n(n);
+  }
+  PrimeResponse response = service.handle(request);
+  EXPECT_EQ(response.id(), 7);
+  ASSERT_EQ(response.result_case(), PrimeResponse::kIsPrime);
+  const auto& prime = response.is_prime().prime();
+  EXPECT_EQ(std::vector<bool>(prime.begin(), prime.end()),
+            std::vector<bool>({false, true, false, true, true}));
+
+  request.mutable_primes_up_to()->set_n(100);
+  response = service.handle(request);
+  ASSERT_EQ(response.result_case(), PrimeResponse::kPrimesUpTo);
+  EXPECT_EQ(response.primes_up_to().primes_size(), 25);
+
+  request.mutable_fibonacci()->add_n(90);
+  response = service.handle(request);
+  ASSERT_EQ(response.result_case(), PrimeResponse::kFibonacci);
+  EXPECT_EQ(response.fibonacci().value(0), fibonacci(90));
+
+  // Bad queries come back as errors rather than exceptions
+  request.mutable_fibonacci()->add_n(94);
+  EXPECT_EQ(service.handle(request).result_case(), PrimeResponse::kError);
+  request.mutable_primes_up_to()->set_n(uint64_t{1} << 40);
+  EXPECT_EQ(service.handle(request).result_case(), PrimeResponse::kError);
+  EXPECT_EQ(service.handle(PrimeRequest()).result_case(), PrimeResponse::kError);
+
+  const ServiceStats stats = service.stats();
+  EXPECT_EQ(stats.requests(), 6);
+  EXPECT_EQ(stats.batched_requests(), 2);
+  EXPECT_GE(stats.cached_prime_bound(), 100);
+  EXPECT_GT(stats.latency_p99_ns(), 0);
+  EXPECT_LE(stats.latency_p50_ns(), stats.latency_p99_ns());
+}
+
+TEST(PrimeServiceTest, ClientServerRoundTrip) {
+  PrimeService::Options options;
+  options.max_delay = 5ms;
+  PrimeService service(options);
+  PrimeServer server(service, socket_path());
+
+  // Concurrent clients, one connection each; their queries may share batches
+  constexpr int kClients = 8;
+  std::vector<std::thread> threads;
+  std::vector<std::string> failures(kClients);
+  for (int c = 0; c < kClients; ++c) {
+    threads.emplace_back([&, c] {
+      try {
+        PrimeServiceClient client(server.path());
+        for (int round = 0; round < 20; ++round) {
+          const uint64_t base = 1000000 * c + 1000 * round;
+          std::vector<uint64_t> ns;
+          for (uint64_t n = base; n < base + 50; ++n) {
+            ns.push_back(n);
+          }
+          const std::vector<bool> prime = client.is_prime(ns);
+          for (size_t i = 0; i < ns.size(); ++i) {
+            if (prime[i] != is_prime(ns[i])) {
+              failures[c] = "is_prime mismatch at " + std::to_string(ns[i]);
+            }
+          }
+          if (client.fibonacci({round, 93})[0] != fibonacci(round)) {
+            failures[c] = "fibonacci mismatch";
+          }
+        }
+        if (client.primes_up_to(1000000) != primes_up_to(1000000)) {
+          failures[c] = "primes_up_to mismatch";
+        }
+      } catch (const std::exception& e) {
+        failures[c] = e.what();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const std::string& failure : failures) {
+    EXPECT_EQ(failure, "");
+  }
+
+  PrimeServiceClient client(server.path());
+  EXPECT_THROW(client.fibonacci({-1}), std::runtime_error);
+  // The stats request itself is counted once it completes
+  const ServiceStats stats = client.stats();
+  EXPECT_EQ(stats.requests(), kClients * 41 + 1);
+  EXPECT_EQ(stats.batched_requests(), kClients * 40);
+  // How many queries share a batch depends on timing; only the bounds are fixed
+  EXPECT_GE(stats.batches(), 1);
+  EXPECT_LE(stats.batches(), stats.batched_requests());
+  EXPECT_EQ(stats.cached_prime_bound(), 1000000);
+}
+
+TEST(PrimeServiceTest, ClientErrors) {
+  EXPECT_THROW(PrimeServiceClient("/nonexistent/ferric.sock"), std::runtime_error);
+  EXPECT_THROW(PrimeServiceClient(std::string(200, 'x')), std::runtime_error);
+}
+
+}  // namespace
+}  // namespace ferric
@@ -0,0 +1,321 @@
+#include "prime_sieve.hh"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <utility>
+
+namespace ferric {
+
+namespace {
+
+// Below this bound the sieving primes come from a plain (unsegmented) sieve
+constexpr uint64_t kSimpleSieveLimit = 1 << 16;
+
+// Chunks a parallel sieve hands each worker
+constexpr uint64_t kChunksPerWorker = 4;
+
+std::vector<uint32_t> simple_sieve(uint32_t limit) {
+  std::vector<uint32_t> primes;
+  std::vector<bool> composite(limit + 1, false);
+  for (uint32_t i = 3; i <= limit; i += 2) {
+    if (composite[i]) {
+      continue;
+    }
+    primes.push_back(i);
+    for (uint64_t j = uint64_t{i} * i; j <= limit; j += 2 * i) {
+      composite[j] = true;
+    }
+  }
+  return primes;
+}
+
+// Odd primes whose multiples are baked into the pre-sieve pattern
+constexpr std::array<uint32_t, 6> kPreSievedPrimes = {3, 5, 7, 11, 13, 17};
+// Product of kPreSievedPrimes: the pattern repeats every this many odd numbers
+constexpr uint64_t kPatternPeriod = 3 * 5 * 7 * 11 * 13 * 17;
+
+// Odd-only bitmap with the multiples of kPreSievedPrimes cleared, starting at
+// the number 1. It is one period plus a full segment long, so any segment can
+// be copied out of it at its phase without wrapping around.
+const std::vector<uint64_t>& presieve_pattern() {
+  static const std::vector<uint64_t> pattern = [] {
+    const uint64_t bits = kPatternPeriod + sieve_segment_bytes() * 8 + 128;
+    std::vector<uint64_t> words((bits + 63) / 64, ~uint64_t{0});
+    for (const uint32_t p : kPreSievedPrimes) {
+      // Bit i is the number 2 * i + 1, so p sits at bit (p - 1) / 2
+      for (uint64_t j = (p - 1) / 2; j < words.size() * 64; j += p) {
+        words[j / 64] &= ~(uint64_t{1} << (j % 64));
+      }
+    }
+    return words;
+  }();
+  return pattern;
+}
+
+// Copy count words of bitmap starting at bit offset shift of src into dst.
+// The loop has no dependencies between iterations and compiles to vector
+// loads, shifts and stores.
+void copy_bits(const uint64_t* __restrict src, unsigned shift, uint64_t* __restrict dst,
+               size_t count) {
+  if (shift == 0) {
+    std::copy_n(src, count, dst);
+    return;
+  }
+  for (size_t w = 0; w < count; ++w) {
+    dst[w] = (src[w] >> shift) | (src[w + 1] << (64 - shift));
+  }
+}
+
+}  // namespace
+
+uint64_t isqrt(uint64_t n) {
+  uint64_t r = static_cast<uint64_t>(std::sqrt(static_cast<double>(n)));
+  // The double estimate can be off by one in either direction near 2^64
+  r = std::min<uint64_t>(r, 0xFFFFFFFF);
+  while (r * r > n) {
+    --r;
+  }
+  while (r < 0xFFFFFFFF && (r + 1) * (r + 1) <= n) {
+    ++r;
+  }
+  return r;
+}
+
+std::vector<uint32_t> sieving_primes(uint64_t limit) {
+  if (limit < kSimpleSieveLimit) {
+    return simple_sieve(static_cast<uint32_t>(limit));
+  }
+  auto small = std::make_shared<const std::vector<uint32_t>>(simple_sieve(isqrt(limit)));
+  std::vector<uint32_t> primes;
+  SegmentedSieve sieve(3, limit + 1, std::move(small));
+  while (sieve.next_segment()) {
+    sieve.for_each_prime([&](uint64_t p) { primes.push_back(static_cast<uint32_t>(p)); });
+  }
+  return primes;
+}
+
+size_t sieve_segment_bytes() {
+  static const size_t bytes = [] {
+    long l1 = 0;
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+#endif
+    if (l1 <= 0) {
+      l1 = 32 * 1024;
+    }
+    // A power of two, so bucket sieving can split a bit index with a shift
+    return std::bit_floor(std::clamp<size_t>(static_cast<size_t>(l1), 16 * 1024, 1024 * 1024));
+  }();
+  return bytes;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> sieve_chunks(uint64_t lo, uint64_t hi,
+                                                        size_t max_chunks) {
+  std::vector<std::pair<uint64_t, uint64_t>> chunks;
+  if (lo >= hi) {
+    return chunks;
+  }
+  // One segment of odd-only bits spans twice as many integers
+  constexpr uint64_t kMinSegmentsPerChunk = 8;
+  const uint64_t segment_span = sieve_segment_bytes() * 8 * 2;
+  const uint64_t length = hi - lo;
+  uint64_t chunk = length / std::max<size_t>(max_chunks, 1) + 1;
+  chunk = std::max(chunk, kMinSegmentsPerChunk * segment_span);
+  chunk = (chunk + segment_span - 1) / segment_span * segment_span;
+  for (uint64_t start = lo; start < hi;) {
+    const uint64_t end = hi - start > chunk ? start + chunk : hi;
+    chunks.emplace_back(start, end);
+    start = end;
+  }
+  return chunks;
+}
+
+SievePlan plan_parallel_sieve(uint64_t lo, uint64_t hi, size_t num_workers) {
+  const uint64_t root = hi > 1 ? isqrt(hi - 1) : 0;
+  const uint64_t workers = std::max<size_t>(num_workers, 1);
+  const uint64_t chunks_by_width = hi > lo ? (hi - lo) / std::max<uint64_t>(root, 1) : 0;
+  const size_t max_chunks = static_cast<size_t>(
+      std::clamp<uint64_t>(chunks_by_width, workers, workers * kChunksPerWorker));
+  return {sieve_chunks(lo, hi, max_chunks),
+          std::make_shared<const std::vector<uint32_t>>(sieving_primes(root))};
+}
+
+SegmentedSieve::SegmentedSieve(uint64_t lo, uint64_t hi)
+    : SegmentedSieve(lo, hi,
+                     std::make_shared<const std::vector<uint32_t>>(
+                         sieving_primes(hi > 1 ? isqrt(hi - 1) : 0))) {}
+
+SegmentedSieve::SegmentedSieve(uint64_t lo, uint64_t hi,
+                               std::shared_ptr<const std::vector<uint32_t>> primes)
+    : has_two_(lo <= 2 && hi > 2), primes_(std::move(primes)) {
+  odd_lo_ = std::max<uint64_t>(lo, 3) | 1;
+  total_bits_ = hi > odd_lo_ ? (hi - odd_lo_ + 1) / 2 : 0;
+  if (total_bits_ == 0) {
+    return;
+  }
+  bits_.resize(sieve_segment_bytes() / 8);
+  const uint64_t segment_bits = bits_.size() * 64;
+
+  // Only primes with p * p < hi cross anything off
+  const uint64_t root = isqrt(hi - 1);
+  num_primes_ = std::upper_bound(primes_->begin(), primes_->end(), root) - primes_->begin();
+  first_prime_ = std::upper_bound(primes_->begin(), primes_->begin() + num_primes_,
+                                  kPreSievedPrimes.back()) -
+                 primes_->begin();
+  num_medium_ = std::lower_bound(primes_->begin() + first_prime_, primes_->begin() + num_primes_,
+                                 segment_bits) -
+                primes_->begin();
+  offsets_.resize(num_medium_ - first_prime_);
+  for (size_t i = first_prime_; i < num_medium_; ++i) {
+    offsets_[i - first_prime_] = first_multiple((*primes_)[i]);
+  }
+
+  // A large prime's next multiple is at most p bits ahead, so it always lands
+  // within the next p / segment_bits + 1 segments
+  next_large_ = num_medium_;
+  if (num_medium_ < num_primes_) {
+    buckets_.resize((*primes_)[num_primes_ - 1] / segment_bits + 2);
+  }
+}
+
+uint64_t SegmentedSieve::first_multiple(uint64_t p) const {
+  const uint64_t square = p * p;
+  if (square >= odd_lo_) {
+    return (square - odd_lo_) / 2;
+  }
+  // First odd multiple of p at or above odd_lo_
+  const uint64_t r = odd_lo_ % p;
+  uint64_t d = r == 0 ? 0 : p - r;
+  if (d & 1) {
+    d += p;
+  }
+  return d / 2;
+}
+
+void SegmentedSieve::fill_buckets() {
+  const int shift = std::countr_zero(bits_.size() * 64);
+  // First multiples are below p bits for primes with p * p < odd_lo_ and grow
+  // with p after that, so the primes that fit form a prefix of what is left
+  for (; next_large_ < num_primes_; ++next_large_) {
+    const uint32_t p = (*primes_)[next_large_];
+    const uint64_t bit = first_multiple(p);
+    if (bit >= total_bits_) {
+      continue;  // No multiple in the range: a narrow window skips most large primes
+    }
+    const uint64_t segment = bit >> shift;
+    if (segment >= segment_ + buckets_.size()) {
+      break;
+    }
+    const uint32_t offset = static_cast<uint32_t>(bit & ((uint64_t{1} << shift) - 1));
+    buckets_[segment % buckets_.size()].push_back({p, offset});
+  }
+}
+
+bool SegmentedSieve::next_segment() {
+  first_segment_ = !started_;
+  if (started_ && seg_bits_ > 0) {
+    ++segment_;
+  }
+  started_ = true;
+  if (next_bit_ >= total_bits_) {
+    // A range without odd numbers may still hold the prime 2
+    seg_bits_ = 0;
+    return first_segment_ && has_two_;
+  }
+
+  seg_lo_ = odd_lo_ + 2 * next_bit_;
+  seg_bits_ = static_cast<size_t>(std::min<uint64_t>(bits_.size() * 64, total_bits_ - next_bit_));
+  next_bit_ += seg_bits_;
+
+  // Start from the pre-sieve pattern at this segment's phase
+  const size_t words = (seg_bits_ + 63) / 64;
+  const uint64_t phase = ((seg_lo_ - 1) / 2) % kPatternPeriod;
+  copy_bits(presieve_pattern().data() + phase / 64, phase % 64, bits_.data(), words);
+  if (seg_bits_ % 64) {
+    bits_[words - 1] &= (uint64_t{1} << (seg_bits_ % 64)) - 1;
+  }
+  // The pattern also clears the pre-sieved primes themselves
+  if (seg_lo_ <= kPreSievedPrimes.back()) {
+    for (const uint32_t p : kPreSievedPrimes) {
+      if (p >= seg_lo_ && (p - seg_lo_) / 2 < seg_bits_) {
+        const uint64_t bit = (p - seg_lo_) / 2;
+        bits_[bit / 64] |= uint64_t{1} << (bit % 64);
+      }
+    }
+  }
+
+  for (size_t i = first_prime_; i < num_medium_; ++i) {
+    const uint64_t p = (*primes_)[i];
+    uint64_t j = offsets_[i - first_prime_];
+    for (; j < seg_bits_; j += p) {
+      bits_[j / 64] &= ~(uint64_t{1} << (j % 64));
+    }
+    offsets_[i - first_prime_] = j - seg_bits_;
+  }
+
+  if (!buckets_.empty()) {
+    fill_buckets();
+    const int shift = std::countr_zero(bits_.size() * 64);
+    const uint64_t mask = (uint64_t{1} << shift) - 1;
+    std::vector<BucketEntry>& bucket = buckets_[segment_ % buckets_.size()];
+    for (const BucketEntry& entry : bucket) {
+      bits_[entry.offset / 64] &= ~(uint64_t{1} << (entry.offset % 64));
+      const uint64_t next = uint64_t{entry.offset} + entry.prime;
+      // Drop primes whose next multiple lies past the end of the range
+      if ((segment_ << shift) + next < total_bits_) {
+        buckets_[(segment_ + (next >> shift)) % buckets_.size()].push_back(
+            {entry.prime, static_cast<uint32_t>(next & mask)});
+      }
+    }
+    bucket.clear();
+  }
+  return true;
+}
+
+uint64_t SegmentedSieve::count_primes() const {
+  uint64_t count = first_segment_ && has_two_ ? 1 : 0;
+  const size_t words = (seg_bits_ + 63) / 64;
+  for (size_t w = 0; w < words; ++w) {
+    count += std::popcount(bits_[w]);
+  }
+  return count;
+}
+
+PrimeRange::PrimeRange(uint64_t lo, uint64_t hi)
+    : cursor_(std::make_unique<Cursor>(SegmentedSieve(lo, hi))) {}
+
+PrimeRange::iterator PrimeRange::begin() {
+  return cursor_->advance() ? iterator(cursor_.get()) : iterator();
+}
+
+bool PrimeRange::Cursor::advance() {
+  while (true) {
+    if (emit_two) {
+      emit_two = false;
+      value = 2;
+      return true;
+    }
+    if (bits) {
+      value = sieve.segment_low() + 2 * (word * 64 + std::countr_zero(bits));
+      bits &= bits - 1;
+      return true;
+    }
+    if (word + 1 < words.size()) {
+      bits = words[++word];
+      continue;
+    }
+    if (!sieve.next_segment()) {
+      return false;
+    }
+    words = sieve.segment_words();
+    word = 0;
+    bits = words.empty() ? 0 : words[0];
+    emit_two = sieve.segment_has_two();
+  }
+}
+
+}  // namespace ferric
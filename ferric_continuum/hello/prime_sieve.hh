@@ -0,0 +1,192 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ferric {
+
+// Largest r such that r * r <= n (exact, no floating-point rounding)
+uint64_t isqrt(uint64_t n);
+
+// Odd primes p <= limit, in increasing order (limit must fit in uint32_t)
+std::vector<uint32_t> sieving_primes(uint64_t limit);
+
+// Bytes of sieve bitmap processed per segment, sized to the L1 data cache
+size_t sieve_segment_bytes();
+
+// Split [lo, hi) into at most max_chunks consecutive ranges for independent
+// sieving. Chunks cover whole segments so no worker sieves a sliver.
+std::vector<std::pair<uint64_t, uint64_t>> sieve_chunks(uint64_t lo, uint64_t hi,
+                                                        size_t max_chunks);
+
+// Work for sieving [lo, hi) in parallel: the chunks, and the table of sieving
+// primes up to sqrt(hi) that every chunk shares read-only
+struct SievePlan {
+  std::vector<std::pair<uint64_t, uint64_t>> chunks;
+  std::shared_ptr<const std::vector<uint32_t>> primes;
+};
+
+// Plan [lo, hi) for num_workers workers. Several chunks per worker even out
+// load imbalance, but every chunk places all sieving primes before it sieves,
+// so a window much narrower than hi is split no finer than one per worker.
+SievePlan plan_parallel_sieve(uint64_t lo, uint64_t hi, size_t num_workers);
+
+// Segmented Sieve of Eratosthenes over the half-open range [lo, hi).
+//
+// Only odd numbers are stored, one bit each, and the range is crossed off one
+// cache-sized segment at a time. Memory is O(sqrt(hi)) for the sieving primes
+// plus a single segment, independent of the length of the range.
+//
+// Each segment starts as a copy of a precomputed pattern with the multiples
+// of 3..17 already removed, so the densest primes never run a crossing-off
+// loop. Primes smaller than a segment keep a running offset and are walked
+// every segment; larger primes hit a segment at most once, so, as in
+// primesieve, each waits in a bucket for the segment holding its next multiple
+// and costs nothing in the segments it skips.
+class SegmentedSieve {
+ public:
+  SegmentedSieve(uint64_t lo, uint64_t hi);
+
+  // Reuses a precomputed table of odd sieving primes covering sqrt(hi)
+  SegmentedSieve(uint64_t lo, uint64_t hi, std::shared_ptr<const std::vector<uint32_t>> primes);
+
+  // Sieve the next segment; returns false once the range is exhausted
+  bool next_segment();
+
+  // Call f(p) for every prime in the current segment, in increasing order
+  template <typename F>
+  void for_each_prime(F&& f) const;
+
+  // Number of primes in the current segment
+  uint64_t count_primes() const;
+
+  // Bitmap of the current segment: bit i set means segment_low() + 2 * i is
+  // prime. The prime 2 is not in the bitmap; see segment_has_two().
+  std::span<const uint64_t> segment_words() const {
+    return {bits_.data(), (seg_bits_ + 63) / 64};
+  }
+  uint64_t segment_low() const { return seg_lo_; }
+  // One past the last odd number of the current segment: [lo, segment_end())
+  // has been fully sieved once the current segment is consumed
+  uint64_t segment_end() const { return seg_lo_ + 2 * seg_bits_; }
+  bool segment_has_two() const { return first_segment_ && has_two_; }
+
+ private:
+  uint64_t odd_lo_;      // First odd number covered by the bitmap
+  uint64_t total_bits_;  // Odd numbers in [odd_lo_, hi)
+  uint64_t next_bit_ = 0;
+  uint64_t seg_lo_ = 0;  // First odd number of the current segment
+  size_t seg_bits_ = 0;
+  bool has_two_;         // 2 lies in the range and is reported with the first segment
+  bool started_ = false;
+  bool first_segment_ = false;
+
+  // A large sieving prime and its next multiple, as a bit index into the
+  // segment whose bucket holds it
+  struct BucketEntry {
+    uint32_t prime;
+    uint32_t offset;
+  };
+
+  // Bit index of the first odd multiple of p that needs crossing off, relative to odd_lo_
+  uint64_t first_multiple(uint64_t p) const;
+  // Move large primes whose first multiple falls within the bucket ring into it
+  void fill_buckets();
+
+  std::shared_ptr<const std::vector<uint32_t>> primes_;
+  size_t first_prime_ = 0;   // primes_ before this index are covered by the pre-sieve pattern
+  size_t num_medium_ = 0;    // primes_[first_prime_, num_medium_) are walked every segment
+  size_t num_primes_ = 0;    // Prefix of primes_ with p * p < hi
+  size_t next_large_ = 0;    // First large prime not yet placed in a bucket
+  uint64_t segment_ = 0;     // Index of the current segment
+  std::vector<uint64_t> offsets_;  // Next multiple of each medium prime, as a segment bit index
+  std::vector<std::vector<BucketEntry>> buckets_;  // Ring of buckets, one per upcoming segment
+  std::vector<uint64_t> bits_;
+};
+
+// Lazily generated primes in [lo, hi), as a single-pass C++20 input range.
+//
+// The sieve advances one segment at a time as the range is consumed, so
+// resident memory is O(sqrt(hi)) however long the range is:
+//
+//   for (uint64_t p : prime_range(lo, hi)) { ... }
+class PrimeRange {
+ public:
+  class iterator;
+
+  PrimeRange(uint64_t lo, uint64_t hi);
+
+  // Only one traversal is possible; begin() must be called at most once
+  iterator begin();
+  std::default_sentinel_t end() const { return {}; }
+
+ private:
+  struct Cursor;
+  std::unique_ptr<Cursor> cursor_;  // Heap-held so iterators survive moves of the range
+};
+
+struct PrimeRange::Cursor {
+  explicit Cursor(SegmentedSieve s) : sieve(std::move(s)) {}
+
+  // Step to the next prime; returns false once the range is exhausted
+  bool advance();
+
+  SegmentedSieve sieve;
+  std::span<const uint64_t> words;
+  size_t word = 0;
+  uint64_t bits = 0;  // Unvisited primes of words[word]
+  bool emit_two = false;
+  uint64_t value = 0;
+};
+
+class PrimeRange::iterator {
+ public:
+  using value_type = uint64_t;
+  using difference_type = std::ptrdiff_t;
+  using iterator_concept = std::input_iterator_tag;
+
+  iterator() = default;
+
+  uint64_t operator*() const { return cursor_->value; }
+  iterator& operator++() {
+    if (!cursor_->advance()) {
+      cursor_ = nullptr;
+    }
+    return *this;
+  }
+  void operator++(int) { ++*this; }
+
+  friend bool operator==(const iterator& it, std::default_sentinel_t) {
+    return it.cursor_ == nullptr;
+  }
+
+ private:
+  friend class PrimeRange;
+  explicit iterator(Cursor* cursor) : cursor_(cursor) {}
+
+  Cursor* cursor_ = nullptr;
+};
+
+template <typename F>
+void SegmentedSieve::for_each_prime(F&& f) const {
+  if (first_segment_ && has_two_) {
+    f(uint64_t{2});
+  }
+  const size_t words = (seg_bits_ + 63) / 64;
+  for (size_t w = 0; w < words; ++w) {
+    uint64_t word = bits_[w];
+    while (word) {
+      const uint64_t bit = w * 64 + std::countr_zero(word);
+      f(seg_lo_ + 2 * bit);
+      word &= word - 1;
+    }
+  }
+}
+
+}  // namespace ferric
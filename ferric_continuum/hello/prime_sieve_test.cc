@@ -0,0 +1,195 @@
+#include "prime_sieve.hh"
+
+#include <gtest/gtest.h>
+
+#include <ranges>
+
+namespace ferric {
+namespace {
+
+// Reference implementation: trial division
+bool naive_is_prime(uint64_t n) {
+  if (n < 2)
+    return false;
+  for (uint64_t d = 2; d * d <= n; ++d) {
+    if (n % d == 0)
+      return false;
+  }
+  return true;
+}
+
+std::vector<uint64_t> sieve_range(uint64_t lo, uint64_t hi) {
+  std::vector<uint64_t> primes;
+  SegmentedSieve sieve(lo, hi);
+  while (sieve.next_segment()) {
+    sieve.for_each_prime([&](uint64_t p) { primes.push_back(p); });
+  }
+  return primes;
+}
+
+uint64_t count_range(uint64_t lo, uint64_t hi) {
+  uint64_t count = 0;
+  SegmentedSieve sieve(lo, hi);
+  while (sieve.next_segment()) {
+    count += sieve.count_primes();
+  }
+  return count;
+}
+
+TEST(PrimeSieveTest, Isqrt) {
+  EXPECT_EQ(isqrt(0), 0);
+  EXPECT_EQ(isqrt(1), 1);
+  EXPECT_EQ(isqrt(15), 3);
+  EXPECT_EQ(isqrt(16), 4);
+  EXPECT_EQ(isqrt(0xFFFFFFFE00000001ULL), 0xFFFFFFFF);
+  EXPECT_EQ(isqrt(0xFFFFFFFE00000000ULL), 0xFFFFFFFE);
+  EXPECT_EQ(isqrt(UINT64_MAX), 0xFFFFFFFF);
+}
+
+TEST(PrimeSieveTest, SievingPrimes) {
+  std::vector<uint32_t> expected = {3, 5, 7, 11, 13, 17, 19};
+  EXPECT_EQ(sieving_primes(20), expected);
+  EXPECT_TRUE(sieving_primes(2).empty());
+  // pi(10^6) = 78498, minus the prime 2
+  EXPECT_EQ(sieving_primes(1000000).size(), 78497);
+}
+
+TEST(PrimeSieveTest, PlanParallelSieve) {
+  const auto covers = [](const SievePlan& plan, uint64_t lo, uint64_t hi) {
+    uint64_t next = lo;
+    for (const auto& [start, end] : plan.chunks) {
+      if (start != next || end <= start) {
+        return false;
+      }
+      next = end;
+    }
+    return next == hi;
+  };
+  const SievePlan wide = plan_parallel_sieve(0, 1000000000, 4);
+  EXPECT_TRUE(covers(wide, 0, 1000000000));
+  EXPECT_GT(wide.chunks.size(), 4);
+  EXPECT_LE(wide.chunks.size(), 16);
+  EXPECT_EQ(*wide.primes, sieving_primes(isqrt(1000000000 - 1)));
+
+  // Each chunk places every sieving prime below 2^24, so this window is not
+  // worth splitting beyond one chunk per worker
+  const uint64_t lo = uint64_t{1} << 48;
+  const SievePlan narrow = plan_parallel_sieve(lo, lo + (uint64_t{1} << 26), 4);
+  EXPECT_TRUE(covers(narrow, lo, lo + (uint64_t{1} << 26)));
+  EXPECT_LE(narrow.chunks.size(), 4);
+
+  EXPECT_TRUE(plan_parallel_sieve(10, 10, 4).chunks.empty());
+}
+
+TEST(PrimeSieveTest, SmallRanges) {
+  EXPECT_TRUE(sieve_range(0, 2).empty());
+  EXPECT_EQ(sieve_range(0, 3), std::vector<uint64_t>({2}));
+  EXPECT_EQ(sieve_range(2, 3), std::vector<uint64_t>({2}));
+  EXPECT_EQ(sieve_range(3, 4), std::vector<uint64_t>({3}));
+  EXPECT_EQ(sieve_range(0, 12), std::vector<uint64_t>({2, 3, 5, 7, 11}));
+  EXPECT_TRUE(sieve_range(24, 29).empty());
+  EXPECT_EQ(sieve_range(24, 32), std::vector<uint64_t>({29, 31}));
+  EXPECT_TRUE(sieve_range(10, 10).empty());
+  EXPECT_TRUE(sieve_range(20, 10).empty());
+}
+
+TEST(PrimeSieveTest, MatchesTrialDivision) {
+  for (uint64_t lo : {0, 1, 2, 3, 100, 997, 1000000}) {
+    std::vector<uint64_t> expected;
+    for (uint64_t n = lo; n < lo + 3000; ++n) {
+      if (naive_is_prime(n)) {
+        expected.push_back(n);
+      }
+    }
+    EXPECT_EQ(sieve_range(lo, lo + 3000), expected) << "lo = " << lo;
+  }
+}
+
+TEST(PrimeSieveTest, CountsAcrossSegments) {
+  // The range spans many L1-sized segments
+  EXPECT_EQ(count_range(0, 10000000), 664579);
+  EXPECT_EQ(sieve_range(0, 10000000).size(), 664579);
+}
+
+TEST(PrimeSieveTest, LargeWindows) {
+  // Largest prime below 2^32
+  EXPECT_EQ(sieve_range(4294967200ULL, 4294967296ULL).back(), 4294967291ULL);
+
+  const uint64_t lo = 1000000000000ULL;
+  std::vector<uint64_t> expected;
+  for (uint64_t n = lo; n < lo + 200; ++n) {
+    if (naive_is_prime(n)) {
+      expected.push_back(n);
+    }
+  }
+  EXPECT_EQ(sieve_range(lo, lo + 200), expected);
+}
+
+TEST(PrimeSieveTest, BucketSievedPrimes) {
+  // Most sieving primes up to 10^6 are larger than a segment, so they are
+  // crossed off from buckets rather than on every segment
+  EXPECT_EQ(count_range(1000000000000ULL, 1000010000000ULL), 361726);
+
+  // The tail of a long window, after entries have cycled through the buckets
+  const uint64_t lo = 1000000000000ULL;
+  const uint64_t hi = lo + 3000000;
+  std::vector<uint64_t> expected;
+  for (uint64_t n = hi - 300; n < hi; ++n) {
+    if (naive_is_prime(n)) {
+      expected.push_back(n);
+    }
+  }
+  const auto primes = sieve_range(lo, hi);
+  EXPECT_EQ(std::vector<uint64_t>(primes.end() - expected.size(), primes.end()), expected);
+}
+
+TEST(PrimeSieveTest, PreSievedPrimesSurvive) {
+  // 3..17 are cleared by the pre-sieve pattern and must be put back
+  EXPECT_EQ(sieve_range(0, 20), std::vector<uint64_t>({2, 3, 5, 7, 11, 13, 17, 19}));
+  EXPECT_EQ(sieve_range(13, 18), std::vector<uint64_t>({13, 17}));
+  // Segments starting at every phase of the pattern still split counts exactly
+  EXPECT_EQ(count_range(0, 1234567) + count_range(1234567, 10000000), 664579);
+}
+
+static_assert(std::ranges::input_range<PrimeRange>);
+
+std::vector<uint64_t> collect(uint64_t lo, uint64_t hi) {
+  std::vector<uint64_t> primes;
+  for (uint64_t p : PrimeRange(lo, hi)) {
+    primes.push_back(p);
+  }
+  return primes;
+}
+
+TEST(PrimeSieveTest, PrimeRangeMatchesSieve) {
+  EXPECT_TRUE(collect(0, 2).empty());
+  EXPECT_EQ(collect(0, 3), std::vector<uint64_t>({2}));
+  EXPECT_EQ(collect(0, 30), std::vector<uint64_t>({2, 3, 5, 7, 11, 13, 17, 19, 23, 29}));
+  EXPECT_EQ(collect(0, 3000000), sieve_range(0, 3000000));
+  EXPECT_EQ(collect(1000000000000ULL, 1000000100000ULL),
+            sieve_range(1000000000000ULL, 1000000100000ULL));
+}
+
+TEST(PrimeSieveTest, PrimeRangeIsLazy) {
+  // Only the first few segments of a huge range are ever sieved
+  PrimeRange range(1000000000000ULL, 2000000000000ULL);
+  std::vector<uint64_t> first;
+  for (uint64_t p : range | std::views::take(3)) {
+    first.push_back(p);
+  }
+  EXPECT_EQ(first, std::vector<uint64_t>({1000000000039ULL, 1000000000061ULL, 1000000000063ULL}));
+}
+
+TEST(PrimeSieveTest, PrimeRangeSurvivesMove) {
+  PrimeRange range(10, 40);
+  auto it = range.begin();
+  PrimeRange moved = std::move(range);
+  std::vector<uint64_t> primes;
+  for (; it != moved.end(); ++it) {
+    primes.push_back(*it);
+  }
+  EXPECT_EQ(primes, std::vector<uint64_t>({11, 13, 17, 19, 23, 29, 31, 37}));
+}
+
+}  // namespace
+}  // namespace ferric
@@ -0,0 +1,203 @@
+#include "prime_stats.hh"
+
+#include "prime_sieve.hh"
+#include "thread_pool.hh"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <future>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace ferric {
+
+namespace {
+
+// kIndexBits[k] selects the bit positions whose index has bit k set, so the
+// indices of the set bits of w sum to sum_k popcount(w & kIndexBits[k]) << k
+constexpr std::array<uint64_t, 6> kIndexBits = {
+    0xAAAAAAAAAAAAAAAA, 0xCCCCCCCCCCCCCCCC, 0xF0F0F0F0F0F0F0F0,
+    0xFF00FF00FF00FF00, 0xFFFF0000FFFF0000, 0xFFFFFFFF00000000,
+};
+
+uint64_t set_bit_index_sum(uint64_t word) {
+  uint64_t sum = 0;
+  for (size_t k = 0; k < kIndexBits.size(); ++k) {
+    sum += static_cast<uint64_t>(std::popcount(word & kIndexBits[k])) << k;
+  }
+  return sum;
+}
+
+// Statistics of one contiguous run of the range, plus its first and last
+// primes so that neighbouring runs can be stitched together
+class Accumulator {
+ public:
+  explicit Accumulator(StatsMask mask) : mask_(mask) {}
+
+  void add_segment(const SegmentedSieve& sieve);
+
+  // Fold in the run that immediately follows this one
+  void append(const Accumulator& next);
+
+  PrimeStats take() { return std::move(stats_); }
+
+ private:
+  void record_gap(uint64_t start, uint64_t gap);
+  void add_prime(uint64_t p);
+
+  StatsMask mask_;
+  PrimeStats stats_;
+  uint64_t first_ = 0;  // Zero until a prime is seen
+  uint64_t last_ = 0;
+};
+
+void Accumulator::record_gap(uint64_t start, uint64_t gap) {
+  if (gap >= stats_.gap_histogram.size()) {
+    stats_.gap_histogram.resize(gap + 1);
+  }
+  ++stats_.gap_histogram[gap];
+  // Strictly larger, so the first occurrence of the maximum wins
+  if (gap > stats_.max_gap) {
+    stats_.max_gap = gap;
+    stats_.max_gap_start = start;
+  }
+}
+
+// A prime taken one at a time: 2, which the bitmap leaves out
+void Accumulator::add_prime(uint64_t p) {
+  if (has(mask_, StatsMask::kCount)) {
+    ++stats_.count;
+  }
+  if (has(mask_, StatsMask::kSum)) {
+    stats_.sum += p;
+  }
+  if (has(mask_, StatsMask::kGaps) && last_ != 0) {
+    record_gap(last_, p - last_);
+  }
+  first_ = first_ != 0 ? first_ : p;
+  last_ = p;
+}
+
+void Accumulator::add_segment(const SegmentedSieve& sieve) {
+  if (sieve.segment_has_two()) {
+    add_prime(2);
+  }
+  const std::span<const uint64_t> words = sieve.segment_words();
+  const uint64_t low = sieve.segment_low();  // Bit i of word w is low + 128 * w + 2 * i
+  const auto nonzero = [](uint64_t w) { return w != 0; };
+  const auto first_word = std::find_if(words.begin(), words.end(), nonzero);
+  if (first_word == words.end()) {
+    return;
+  }
+  const size_t fw = static_cast<size_t>(first_word - words.begin());
+  const size_t lw = words.size() - 1 -
+                    static_cast<size_t>(std::find_if(words.rbegin(), words.rend(), nonzero) -
+                                        words.rbegin());
+  const uint64_t segment_first = low + 128 * fw + 2 * std::countr_zero(words[fw]);
+  const uint64_t segment_last = low + 128 * lw + 2 * (63 - std::countl_zero(words[lw]));
+
+  if (has(mask_, StatsMask::kTwins)) {
+    uint64_t twins = last_ != 0 && segment_first - last_ == 2;
+    uint64_t carry = 0;  // Top bit of the previous word, which pairs with bit 0 of the next
+    for (size_t w = fw; w <= lw; ++w) {
+      twins += std::popcount(words[w] & words[w] >> 1) + (carry & words[w]);
+      carry = words[w] >> 63;
+    }
+    stats_.twin_pairs += twins;
+  }
+  if (has(mask_, StatsMask::kCount)) {
+    uint64_t count = 0;
+    for (size_t w = fw; w <= lw; ++w) {
+      count += std::popcount(words[w]);
+    }
+    stats_.count += count;
+  }
+  if (has(mask_, StatsMask::kSum)) {
+    unsigned __int128 sum = 0;
+    for (size_t w = fw; w <= lw; ++w) {
+      const uint64_t base = low + 128 * w;
+      sum += static_cast<unsigned __int128>(base) * std::popcount(words[w]) +
+             2 * set_bit_index_sum(words[w]);
+    }
+    stats_.sum += sum;
+  }
+  if (has(mask_, StatsMask::kGaps)) {
+    uint64_t last = last_;
+    for (size_t w = fw; w <= lw; ++w) {
+      for (uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+        const uint64_t p = low + 128 * w + 2 * std::countr_zero(bits);
+        if (last != 0) {
+          record_gap(last, p - last);
+        }
+        last = p;
+      }
+    }
+  }
+  first_ = first_ != 0 ? first_ : segment_first;
+  last_ = segment_last;
+}
+
+void Accumulator::append(const Accumulator& next) {
+  if (next.first_ == 0) {
+    return;
+  }
+  // The gap between the two runs comes before any gap inside next
+  if (last_ != 0) {
+    const uint64_t gap = next.first_ - last_;
+    if (has(mask_, StatsMask::kTwins) && gap == 2) {
+      ++stats_.twin_pairs;
+    }
+    if (has(mask_, StatsMask::kGaps)) {
+      record_gap(last_, gap);
+    }
+  }
+  const PrimeStats& other = next.stats_;
+  stats_.count += other.count;
+  stats_.sum += other.sum;
+  stats_.twin_pairs += other.twin_pairs;
+  if (other.gap_histogram.size() > stats_.gap_histogram.size()) {
+    stats_.gap_histogram.resize(other.gap_histogram.size());
+  }
+  for (size_t g = 0; g < other.gap_histogram.size(); ++g) {
+    stats_.gap_histogram[g] += other.gap_histogram[g];
+  }
+  if (other.max_gap > stats_.max_gap) {
+    stats_.max_gap = other.max_gap;
+    stats_.max_gap_start = other.max_gap_start;
+  }
+  first_ = first_ != 0 ? first_ : next.first_;
+  last_ = next.last_;
+}
+
+}  // namespace
+
+PrimeStats prime_stats(uint64_t lo, uint64_t hi, StatsMask mask, size_t num_threads) {
+  if (lo >= hi) {
+    return {};
+  }
+  ThreadPool pool(num_threads);
+  const auto [chunks, primes] = plan_parallel_sieve(lo, hi, pool.size());
+
+  std::vector<Accumulator> parts(chunks.size(), Accumulator(mask));
+  std::vector<std::future<void>> done;
+  done.reserve(chunks.size());
+  for (size_t c = 0; c < chunks.size(); ++c) {
+    done.push_back(pool.submit([&, c] {
+      SegmentedSieve sieve(chunks[c].first, chunks[c].second, primes);
+      while (sieve.next_segment()) {
+        parts[c].add_segment(sieve);
+      }
+    }));
+  }
+  wait_all(done);
+
+  Accumulator total(mask);
+  for (const Accumulator& part : parts) {
+    total.append(part);
+  }
+  return total.take();
+}
+
+}  // namespace ferric
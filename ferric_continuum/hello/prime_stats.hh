@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ferric {
+
+// Aggregates prime_stats can compute; fields left out of the mask stay zero
+enum class StatsMask : uint32_t {
+  kCount = 1 << 0,
+  kSum = 1 << 1,
+  kTwins = 1 << 2,
+  kGaps = 1 << 3,
+  kAll = kCount | kSum | kTwins | kGaps,
+};
+
+constexpr StatsMask operator|(StatsMask a, StatsMask b) {
+  return static_cast<StatsMask>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+constexpr bool has(StatsMask mask, StatsMask field) {
+  return (static_cast<uint32_t>(mask) & static_cast<uint32_t>(field)) != 0;
+}
+
+struct PrimeStats {
+  uint64_t count = 0;                   // kCount: primes in [lo, hi)
+  unsigned __int128 sum = 0;            // kSum: their sum, which outgrows uint64_t near 3 * 10^10
+  uint64_t twin_pairs = 0;              // kTwins: pairs p, p + 2 with both in [lo, hi)
+  uint64_t max_gap = 0;                 // kGaps: largest gap between consecutive primes
+  uint64_t max_gap_start = 0;           // kGaps: the prime opening the first such gap
+  std::vector<uint64_t> gap_histogram;  // kGaps: [g] = consecutive primes g apart
+};
+
+// Statistics of the primes in [lo, hi) in one pass over the sieve, without
+// materializing them. The window is split across num_threads workers (0 =
+// one per hardware thread), as in primes_in_range, and each segment is
+// reduced straight from its bitmap: counts, twins and sums take a few
+// popcounts per 64-bit word, and only kGaps visits primes one at a time.
+// Partial results are merged in order, including across chunk boundaries.
+PrimeStats prime_stats(uint64_t lo, uint64_t hi, StatsMask mask = StatsMask::kAll,
+                       size_t num_threads = 0);
+
+}  // namespace ferric
@@ -0,0 +1,87 @@
+#include "prime_stats.hh"
+
+#include "hello_lib.hh"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+// The same statistics from a materialized prime list
+PrimeStats reference_stats(uint64_t lo, uint64_t hi) {
+  PrimeStats stats;
+  const std::vector<uint64_t> primes = primes_in_range(lo, hi, 1);
+  stats.count = primes.size();
+  for (size_t i = 0; i < primes.size(); ++i) {
+    stats.sum += primes[i];
+    if (i == 0) {
+      continue;
+    }
+    const uint64_t gap = primes[i] - primes[i - 1];
+    stats.twin_pairs += gap == 2;
+    if (gap >= stats.gap_histogram.size()) {
+      stats.gap_histogram.resize(gap + 1);
+    }
+    ++stats.gap_histogram[gap];
+    if (gap > stats.max_gap) {
+      stats.max_gap = gap;
+      stats.max_gap_start = primes[i - 1];
+    }
+  }
+  return stats;
+}
+
+void expect_equal(const PrimeStats& actual, const PrimeStats& expected) {
+  EXPECT_EQ(actual.count, expected.count);
+  EXPECT_TRUE(actual.sum == expected.sum);
+  EXPECT_EQ(actual.twin_pairs, expected.twin_pairs);
+  EXPECT_EQ(actual.max_gap, expected.max_gap);
+  EXPECT_EQ(actual.max_gap_start, expected.max_gap_start);
+  EXPECT_EQ(actual.gap_histogram, expected.gap_histogram);
+}
+
+TEST(PrimeStatsTest, MatchesMaterializedPrimes) {
+  const std::vector<std::pair<uint64_t, uint64_t>> ranges = {
+      {0, 0},       {0, 2},       {0, 3},        {2, 3},          {3, 6},
+      {0, 100},     {4, 100},     {5, 7},        {0, 1000000},    {999983, 1000003},
+      {123457, 7654321}, {uint64_t{1} << 40, (uint64_t{1} << 40) + 5000000},
+  };
+  for (const auto& [lo, hi] : ranges) {
+    SCOPED_TRACE(testing::Message() << "[" << lo << ", " << hi << ")");
+    const PrimeStats expected = reference_stats(lo, hi);
+    // Thread counts change where chunks split, which must not change the result
+    for (const size_t threads : {1, 3, 8}) {
+      expect_equal(prime_stats(lo, hi, StatsMask::kAll, threads), expected);
+    }
+  }
+}
+
+TEST(PrimeStatsTest, KnownValues) {
+  const PrimeStats stats = prime_stats(0, 100000000);
+  EXPECT_EQ(stats.count, 5761455);
+  EXPECT_TRUE(stats.sum == 279209790387276);
+  EXPECT_EQ(stats.twin_pairs, 440312);
+  EXPECT_EQ(stats.max_gap, 220);
+  EXPECT_EQ(stats.max_gap_start, 47326693);
+  EXPECT_EQ(stats.gap_histogram[1], 1);
+  EXPECT_EQ(stats.gap_histogram[2], 440312);
+}
+
+TEST(PrimeStatsTest, ComputesOnlyRequestedFields) {
+  const PrimeStats stats = prime_stats(0, 1000000, StatsMask::kCount | StatsMask::kTwins);
+  EXPECT_EQ(stats.count, 78498);
+  EXPECT_EQ(stats.twin_pairs, 8169);
+  EXPECT_TRUE(stats.sum == 0);
+  EXPECT_EQ(stats.max_gap, 0);
+  EXPECT_TRUE(stats.gap_histogram.empty());
+
+  const PrimeStats sum = prime_stats(0, 1000000, StatsMask::kSum);
+  EXPECT_TRUE(sum.sum == 37550402023);
+  EXPECT_EQ(sum.count, 0);
+}
+
+}  // namespace
+}  // namespace ferric
@@ -0,0 +1,402 @@
+#include "prime_table.hh"
+
+#include "prime_sieve.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ferric {
+
+namespace {
+
+// Residues mod 30 that can hold a prime > 5, in bit order
+constexpr std::array<uint64_t, 8> kWheel = {1, 7, 11, 13, 17, 19, 23, 29};
+
+// Wheel bit of each residue, or -1 for residues sharing a factor with 30
+constexpr std::array<int, 30> make_bit_of_residue() {
+  std::array<int, 30> bits{};
+  bits.fill(-1);
+  for (int j = 0; j < 8; ++j) {
+    bits[kWheel[j]] = j;
+  }
+  return bits;
+}
+constexpr std::array<int, 30> kBitOfResidue = make_bit_of_residue();
+
+// Number of wheel residues <= r
+constexpr std::array<uint64_t, 30> make_residues_up_to() {
+  std::array<uint64_t, 30> counts{};
+  uint64_t count = 0;
+  for (uint64_t r = 0; r < 30; ++r) {
+    count += kBitOfResidue[r] >= 0;
+    counts[r] = count;
+  }
+  return counts;
+}
+constexpr std::array<uint64_t, 30> kResiduesUpTo = make_residues_up_to();
+
+constexpr std::array<uint64_t, 3> kPreWheel = {2, 3, 5};
+
+// Heap storage of a freshly sieved table
+struct Arrays {
+  std::vector<uint64_t> words;
+  std::vector<uint64_t> ranks;
+  std::vector<uint64_t> selects;
+};
+
+// On-disk layout: this header, then the words, ranks and selects sections as
+// little-endian uint64 arrays. The 64-byte header keeps every section aligned.
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_bytes;
+  uint64_t bound;
+  uint64_t total;
+  uint64_t num_words;
+  uint64_t num_ranks;
+  uint64_t num_selects;
+  uint64_t checksum;  // Of the three sections
+};
+static_assert(sizeof(FileHeader) == 64);
+
+constexpr char kMagic[8] = {'F', 'C', 'P', 'R', 'I', 'M', 'E', '\0'};
+constexpr uint32_t kFormatVersion = 1;
+
+// Four independent multiply-xor lanes so the checksum runs near memory
+// bandwidth; it guards against truncation and corruption, not tampering
+uint64_t checksum(std::span<const uint64_t> data, uint64_t seed) {
+  constexpr uint64_t kMul = 0x9E3779B97F4A7C15ULL;
+  std::array<uint64_t, 4> lanes = {seed, seed ^ 1, seed ^ 2, seed ^ 3};
+  size_t i = 0;
+  for (; i + 4 <= data.size(); i += 4) {
+    for (size_t l = 0; l < 4; ++l) {
+      lanes[l] = std::rotl((lanes[l] ^ data[i + l]) * kMul, 29);
+    }
+  }
+  for (; i < data.size(); ++i) {
+    lanes[0] = std::rotl((lanes[0] ^ data[i]) * kMul, 29);
+  }
+  uint64_t h = data.size();
+  for (uint64_t lane : lanes) {
+    h = std::rotl((h ^ lane) * kMul, 31);
+  }
+  return h;
+}
+
+[[noreturn]] void throw_io_error(const std::string& what, const std::string& path) {
+  throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+// Make a rename into path's directory durable: until the directory itself is
+// synced, a crash can still lose the new name
+void sync_parent_directory(const std::string& path) {
+  const size_t slash = path.rfind('/');
+  const std::string dir =
+      slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+  const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    throw_io_error("PrimeTable::save: cannot open directory", dir);
+  }
+  const int result = ::fsync(fd);
+  const int saved = errno;
+  ::close(fd);
+  if (result != 0) {
+    errno = saved;
+    throw_io_error("PrimeTable::save: cannot sync directory", dir);
+  }
+}
+
+// Create path.<pid>.<n>.tmp exclusively, with the permissions the umask gives
+// any new file. n counts up across the process, and a name left behind by an
+// earlier process with the same pid is skipped.
+int create_temporary(const std::string& path, std::string& tmp) {
+  static std::atomic<uint64_t> counter = 0;
+  const std::string prefix = path + "." + std::to_string(::getpid()) + ".";
+  while (true) {
+    tmp = prefix + std::to_string(counter.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (fd >= 0 || errno != EEXIST) {
+      return fd;
+    }
+  }
+}
+
+void write_all(int fd, const void* data, size_t bytes, const std::string& path) {
+  const char* p = static_cast<const char*>(data);
+  while (bytes > 0) {
+    const ssize_t n = ::write(fd, p, bytes);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw_io_error("PrimeTable::save: cannot write", path);
+    }
+    p += n;
+    bytes -= static_cast<size_t>(n);
+  }
+}
+
+// Position of the n-th set bit (0-based) of word
+uint64_t select_in_word(uint64_t word, uint64_t n) {
+  for (; n > 0; --n) {
+    word &= word - 1;
+  }
+  return std::countr_zero(word);
+}
+
+}  // namespace
+
+PrimeTable::PrimeTable(uint64_t bound)
+    : bound_(bound), pre_wheel_((bound >= 2) + (bound >= 3) + (bound >= 5)) {
+  auto arrays = std::make_shared<Arrays>();
+  std::vector<uint64_t>& words = arrays->words;
+  std::vector<uint64_t>& ranks = arrays->ranks;
+  std::vector<uint64_t>& selects = arrays->selects;
+
+  const uint64_t bits = (bound / 30 + 1) * 8;
+  const uint64_t blocks = (bits + 64 * kWordsPerBlock - 1) / (64 * kWordsPerBlock);
+  words.assign(blocks * kWordsPerBlock, 0);
+
+  const uint64_t hi = bound == std::numeric_limits<uint64_t>::max() ? bound : bound + 1;
+  SegmentedSieve sieve(7, hi);
+  while (sieve.next_segment()) {
+    sieve.for_each_prime([&](uint64_t p) {
+      const uint64_t bit = p / 30 * 8 + kBitOfResidue[p % 30];
+      words[bit / 64] |= uint64_t{1} << (bit % 64);
+    });
+  }
+
+  ranks.resize(blocks + 1);
+  for (uint64_t b = 0; b < blocks; ++b) {
+    uint64_t count = 0;
+    for (uint64_t w = 0; w < kWordsPerBlock; ++w) {
+      count += std::popcount(words[b * kWordsPerBlock + w]);
+    }
+    ranks[b + 1] = ranks[b] + count;
+  }
+  total_ = ranks.back();
+
+  // selects[j] is the block where the running count first reaches j * kSelectSample + 1
+  uint64_t block = 0;
+  for (uint64_t t = 1; t <= total_; t += kSelectSample) {
+    while (ranks[block + 1] < t) {
+      ++block;
+    }
+    selects.push_back(block);
+  }
+
+  words_ = words;
+  ranks_ = ranks;
+  selects_ = selects;
+  storage_ = std::move(arrays);
+}
+
+PrimeTable::PrimeTable(uint64_t bound, uint64_t total, std::shared_ptr<const void> storage,
+                       std::span<const uint64_t> words, std::span<const uint64_t> ranks,
+                       std::span<const uint64_t> selects)
+    : bound_(bound),
+      pre_wheel_((bound >= 2) + (bound >= 3) + (bound >= 5)),
+      total_(total),
+      storage_(std::move(storage)),
+      words_(words),
+      ranks_(ranks),
+      selects_(selects) {}
+
+void PrimeTable::save(const std::string& path) const {
+  if constexpr (std::endian::native != std::endian::little) {
+    throw std::runtime_error("PrimeTable::save: table files are little-endian only");
+  }
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kFormatVersion;
+  header.header_bytes = sizeof(FileHeader);
+  header.bound = bound_;
+  header.total = total_;
+  header.num_words = words_.size();
+  header.num_ranks = ranks_.size();
+  header.num_selects = selects_.size();
+  header.checksum = checksum(selects_, checksum(ranks_, checksum(words_, kFormatVersion)));
+
+  // A unique temporary in the target directory, so concurrent saves of the
+  // same path never share one and the rename stays within a file system
+  std::string tmp;
+  const int fd = create_temporary(path, tmp);
+  if (fd < 0) {
+    throw_io_error("PrimeTable::save: cannot create", tmp);
+  }
+  try {
+    write_all(fd, &header, sizeof(header), tmp);
+    write_all(fd, words_.data(), words_.size_bytes(), tmp);
+    write_all(fd, ranks_.data(), ranks_.size_bytes(), tmp);
+    write_all(fd, selects_.data(), selects_.size_bytes(), tmp);
+    if (::fsync(fd) != 0) {
+      throw_io_error("PrimeTable::save: cannot sync", tmp);
+    }
+  } catch (...) {
+    ::close(fd);
+    ::unlink(tmp.c_str());
+    throw;
+  }
+  ::close(fd);
+  if (::rename(tmp.c_str(), path.c_str()) != 0) {
+    const int saved = errno;
+    ::unlink(tmp.c_str());
+    errno = saved;
+    throw_io_error("PrimeTable::save: cannot rename onto", path);
+  }
+  sync_parent_directory(path);
+}
+
+PrimeTable PrimeTable::open(const std::string& path, Verify verify) {
+  if constexpr (std::endian::native != std::endian::little) {
+    throw std::runtime_error("PrimeTable::open: table files are little-endian only");
+  }
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw_io_error("PrimeTable::open: cannot open", path);
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw_io_error("PrimeTable::open: cannot stat", path);
+  }
+  const size_t length = static_cast<size_t>(st.st_size);
+  if (length < sizeof(FileHeader)) {
+    ::close(fd);
+    throw std::runtime_error("PrimeTable::open: " + path + " is too short for a table header");
+  }
+  void* addr = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);  // The mapping keeps the file alive
+  if (addr == MAP_FAILED) {
+    throw_io_error("PrimeTable::open: cannot map", path);
+  }
+  std::shared_ptr<const void> mapping(addr, [length](const void* p) {
+    ::munmap(const_cast<void*>(p), length);
+  });
+
+  auto fail = [&](const char* why) {
+    throw std::runtime_error("PrimeTable::open: " + path + ": " + why);
+  };
+  FileHeader header;
+  std::memcpy(&header, addr, sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    fail("not a prime table file");
+  }
+  if (header.version != kFormatVersion || header.header_bytes != sizeof(FileHeader)) {
+    fail("unsupported table format version");
+  }
+  // Section sizes must be exactly what the constructor would produce for the bound
+  const uint64_t bits = (header.bound / 30 + 1) * 8;
+  const uint64_t blocks = (bits + 64 * kWordsPerBlock - 1) / (64 * kWordsPerBlock);
+  const uint64_t selects = (header.total + kSelectSample - 1) / kSelectSample;
+  if (header.num_words != blocks * kWordsPerBlock || header.num_ranks != blocks + 1 ||
+      header.num_selects != selects) {
+    fail("section sizes do not match the bound");
+  }
+  const uint64_t payload = (header.num_words + header.num_ranks + header.num_selects) * 8;
+  if (length != sizeof(FileHeader) + payload) {
+    fail("file size does not match the header");
+  }
+
+  const uint64_t* base =
+      reinterpret_cast<const uint64_t*>(static_cast<const char*>(addr) + sizeof(FileHeader));
+  const std::span<const uint64_t> words(base, header.num_words);
+  const std::span<const uint64_t> ranks(words.data() + words.size(), header.num_ranks);
+  const std::span<const uint64_t> select_blocks(ranks.data() + ranks.size(), header.num_selects);
+  if (ranks.back() != header.total) {
+    fail("rank directory does not match the prime count");
+  }
+  if (verify == Verify::kFull &&
+      checksum(select_blocks, checksum(ranks, checksum(words, kFormatVersion))) !=
+          header.checksum) {
+    fail("checksum mismatch");
+  }
+  return PrimeTable(header.bound, header.total, std::move(mapping), words, ranks, select_blocks);
+}
+
+uint64_t PrimeTable::rank(uint64_t bit) const {
+  const uint64_t word = bit / 64;
+  const uint64_t block = word / kWordsPerBlock;
+  uint64_t count = ranks_[block];
+  for (uint64_t w = block * kWordsPerBlock; w < word; ++w) {
+    count += std::popcount(words_[w]);
+  }
+  if (bit % 64) {
+    count += std::popcount(words_[word] & ((uint64_t{1} << (bit % 64)) - 1));
+  }
+  return count;
+}
+
+uint64_t PrimeTable::select(uint64_t t) const {
+  uint64_t block = selects_[(t - 1) / kSelectSample];
+  while (ranks_[block + 1] < t) {
+    ++block;
+  }
+  uint64_t remaining = t - ranks_[block] - 1;
+  for (uint64_t w = block * kWordsPerBlock;; ++w) {
+    const uint64_t count = std::popcount(words_[w]);
+    if (remaining < count) {
+      return w * 64 + select_in_word(words_[w], remaining);
+    }
+    remaining -= count;
+  }
+}
+
+uint64_t PrimeTable::prime_count(uint64_t x) const {
+  if (x > bound_) {
+    throw std::out_of_range("PrimeTable::prime_count: x is above the table bound");
+  }
+  uint64_t count = 0;
+  for (uint64_t p : kPreWheel) {
+    count += x >= p;
+  }
+  // Number 1 sits on the wheel but its bit is never set
+  return count + rank(x / 30 * 8 + kResiduesUpTo[x % 30]);
+}
+
+uint64_t PrimeTable::nth_prime(uint64_t k) const {
+  if (k == 0 || k > size()) {
+    throw std::out_of_range("PrimeTable::nth_prime: k is outside the table");
+  }
+  if (k <= pre_wheel_) {
+    return kPreWheel[k - 1];
+  }
+  const uint64_t bit = select(k - pre_wheel_);
+  return bit / 8 * 30 + kWheel[bit % 8];
+}
+
+uint64_t PrimeTable::next_prime(uint64_t x) const {
+  if (x >= bound_) {
+    throw std::out_of_range("PrimeTable::next_prime: x is at or above the table bound");
+  }
+  return nth_prime(prime_count(x) + 1);
+}
+
+bool PrimeTable::contains(uint64_t x) const {
+  if (x > bound_) {
+    throw std::out_of_range("PrimeTable::contains: x is above the table bound");
+  }
+  if (x < 7) {
+    return x == 2 || x == 3 || x == 5;
+  }
+  const int j = kBitOfResidue[x % 30];
+  if (j < 0) {
+    return false;
+  }
+  const uint64_t bit = x / 30 * 8 + j;
+  return words_[bit / 64] >> (bit % 64) & 1;
+}
+
+}  // namespace ferric
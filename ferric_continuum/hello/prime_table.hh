@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace ferric {
+
+// Immutable table of every prime up to a fixed bound, answering pi(x),
+// nth_prime(k) and next_prime(x) in constant time.
+//
+// Primes other than 2, 3 and 5 are coprime to 30, so each block of 30
+// integers needs only 8 bits (residues 1, 7, 11, 13, 17, 19, 23, 29). That
+// wheel bitmap takes bound / 30 bytes. A rank directory holds the running
+// prime count every 512 bits, and a select sample records the directory block
+// of every 256th prime, so both directions are a lookup plus a few popcounts.
+//
+// A table can be saved to a versioned, checksummed file and later mapped
+// read-only with open(): the bitmap and indexes are used in place, so every
+// process opening the same file shares one copy through the page cache.
+// Copies of a PrimeTable share the same immutable storage.
+class PrimeTable {
+ public:
+  // Sieve every prime <= bound
+  explicit PrimeTable(uint64_t bound);
+
+  // How much of a table file open() checks before trusting it
+  enum class Verify {
+    kHeader,  // Magic, version and section sizes only; pages fault in lazily and
+              // the payload is trusted
+    kFull,    // Also recompute the payload checksum
+  };
+
+  // Write the table to path through a uniquely named temporary file in the same
+  // directory and a rename, so readers never see a partial file and concurrent
+  // saves cannot clobber each other; the file and then the directory are
+  // fsynced. The file's permissions follow the umask, as for any new file.
+  // Throws std::runtime_error on I/O failure.
+  void save(const std::string& path) const;
+
+  // Map a file written by save(). Throws std::runtime_error if it cannot be
+  // read or fails verification.
+  static PrimeTable open(const std::string& path, Verify verify = Verify::kFull);
+
+  uint64_t bound() const { return bound_; }
+
+  // Number of primes in the table
+  uint64_t size() const { return total_ + pre_wheel_; }
+
+  // Number of primes <= x; throws std::out_of_range if x > bound()
+  uint64_t prime_count(uint64_t x) const;
+
+  // The k-th prime, 1-based (nth_prime(1) == 2); throws std::out_of_range
+  // if k is 0 or larger than size()
+  uint64_t nth_prime(uint64_t k) const;
+
+  // Smallest prime > x; throws std::out_of_range if it is not in the table
+  uint64_t next_prime(uint64_t x) const;
+
+  // Whether x is prime; throws std::out_of_range if x > bound()
+  bool contains(uint64_t x) const;
+
+ private:
+  static constexpr uint64_t kWordsPerBlock = 8;   // Rank directory granularity: 512 bits
+  static constexpr uint64_t kSelectSample = 256;  // Primes between select samples
+
+  PrimeTable(uint64_t bound, uint64_t total, std::shared_ptr<const void> storage,
+             std::span<const uint64_t> words, std::span<const uint64_t> ranks,
+             std::span<const uint64_t> selects);
+
+  // Wheel primes (> 5) whose bit index is below bit
+  uint64_t rank(uint64_t bit) const;
+  // Bit index of the t-th wheel prime, 1-based
+  uint64_t select(uint64_t t) const;
+
+  uint64_t bound_;
+  uint64_t pre_wheel_;             // How many of 2, 3 and 5 are <= bound_
+  uint64_t total_ = 0;                  // Wheel primes in the table
+  std::shared_ptr<const void> storage_;  // Heap arrays or a file mapping backing the spans
+  std::span<const uint64_t> words_;     // Wheel bitmap, 240 integers per word
+  std::span<const uint64_t> ranks_;     // Wheel primes before each block of kWordsPerBlock words
+  std::span<const uint64_t> selects_;   // Block holding wheel prime j * kSelectSample + 1
+};
+
+}  // namespace ferric
@@ -0,0 +1,172 @@
+#include "prime_table.hh"
+
+#include "prime_sieve.hh"
+
+#include <gtest/gtest.h>
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+std::vector<uint64_t> reference_primes(uint64_t bound) {
+  std::vector<uint64_t> primes;
+  for (uint64_t p : PrimeRange(0, bound + 1)) {
+    primes.push_back(p);
+  }
+  return primes;
+}
+
+TEST(PrimeTableTest, TinyBounds) {
+  PrimeTable empty(1);
+  EXPECT_EQ(empty.size(), 0);
+  EXPECT_EQ(empty.prime_count(0), 0);
+  EXPECT_EQ(empty.prime_count(1), 0);
+  EXPECT_THROW(empty.nth_prime(1), std::out_of_range);
+
+  PrimeTable table(10);
+  EXPECT_EQ(table.size(), 4);
+  EXPECT_EQ(table.prime_count(4), 2);
+  EXPECT_EQ(table.nth_prime(4), 7);
+  EXPECT_EQ(table.next_prime(5), 7);
+  EXPECT_THROW(table.next_prime(7), std::out_of_range);
+}
+
+TEST(PrimeTableTest, MatchesSieve) {
+  constexpr uint64_t kBound = 1000000;
+  const PrimeTable table(kBound);
+  const auto primes = reference_primes(kBound);
+  ASSERT_EQ(table.size(), primes.size());
+
+  for (uint64_t k = 1; k <= primes.size(); ++k) {
+    ASSERT_EQ(table.nth_prime(k), primes[k - 1]) << k;
+  }
+
+  uint64_t count = 0;
+  for (uint64_t x = 0; x <= kBound; ++x) {
+    const bool prime = count < primes.size() && primes[count] == x;
+    count += prime;
+    ASSERT_EQ(table.prime_count(x), count) << x;
+    ASSERT_EQ(table.contains(x), prime) << x;
+    if (count < primes.size()) {
+      ASSERT_EQ(table.next_prime(x), primes[count]) << x;
+    }
+  }
+}
+
+TEST(PrimeTableTest, OutOfRange) {
+  const PrimeTable table(1000);
+  EXPECT_EQ(table.prime_count(1000), 168);
+  EXPECT_EQ(table.nth_prime(168), 997);
+  EXPECT_THROW(table.prime_count(1001), std::out_of_range);
+  EXPECT_THROW(table.contains(1001), std::out_of_range);
+  EXPECT_THROW(table.nth_prime(0), std::out_of_range);
+  EXPECT_THROW(table.nth_prime(169), std::out_of_range);
+  EXPECT_THROW(table.next_prime(997), std::out_of_range);
+}
+
+std::string temp_path(const std::string& name) {
+  return testing::TempDir() + "/" + name;
+}
+
+TEST(PrimeTableTest, SaveAndOpen) {
+  const PrimeTable built(2000000);
+  const std::string path = temp_path("prime_table_round_trip.bin");
+  built.save(path);
+
+  for (auto verify : {PrimeTable::Verify::kHeader, PrimeTable::Verify::kFull}) {
+    const PrimeTable mapped = PrimeTable::open(path, verify);
+    EXPECT_EQ(mapped.bound(), built.bound());
+    ASSERT_EQ(mapped.size(), built.size());
+    for (uint64_t k = 1; k <= built.size(); k += 997) {
+      EXPECT_EQ(mapped.nth_prime(k), built.nth_prime(k));
+    }
+    EXPECT_EQ(mapped.prime_count(2000000), 148933);
+    EXPECT_EQ(mapped.next_prime(1999990), 1999993);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(PrimeTableTest, ConcurrentSavesOfOnePath) {
+  const std::string path = temp_path("prime_table_concurrent.bin");
+  const PrimeTable small(100000);
+  const PrimeTable large(200000);
+  // Each save writes its own temporary, so whichever rename lands last leaves
+  // a complete, valid file
+  std::vector<std::thread> savers;
+  for (int i = 0; i < 8; ++i) {
+    savers.emplace_back([&, i] { (i % 2 ? large : small).save(path); });
+  }
+  for (auto& saver : savers) {
+    saver.join();
+  }
+  const PrimeTable mapped = PrimeTable::open(path, PrimeTable::Verify::kFull);
+  EXPECT_TRUE(mapped.bound() == small.bound() || mapped.bound() == large.bound());
+  std::remove(path.c_str());
+}
+
+TEST(PrimeTableTest, SaveFollowsUmask) {
+  const std::string path = temp_path("prime_table_umask.bin");
+  const mode_t previous = ::umask(027);
+  PrimeTable(1000).save(path);
+  ::umask(previous);
+  struct stat st;
+  ASSERT_EQ(::stat(path.c_str(), &st), 0);
+  EXPECT_EQ(st.st_mode & 0777, 0640);
+  std::remove(path.c_str());
+}
+
+TEST(PrimeTableTest, CopiesShareStorage) {
+  const std::string path = temp_path("prime_table_copy.bin");
+  PrimeTable(1000).save(path);
+  PrimeTable copy = PrimeTable::open(path);
+  {
+    const PrimeTable original = PrimeTable::open(path);
+    copy = original;
+  }
+  EXPECT_EQ(copy.nth_prime(168), 997);
+  std::remove(path.c_str());
+}
+
+TEST(PrimeTableTest, RejectsDamagedFiles) {
+  const std::string path = temp_path("prime_table_damaged.bin");
+  PrimeTable(100000).save(path);
+
+  // Flip one bit in the bitmap: only the full check notices
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekg(64 + 100);
+    char byte = 0;
+    file.read(&byte, 1);
+    byte ^= 0x10;
+    file.seekp(64 + 100);
+    file.write(&byte, 1);
+  }
+  EXPECT_NO_THROW(PrimeTable::open(path, PrimeTable::Verify::kHeader));
+  EXPECT_THROW(PrimeTable::open(path, PrimeTable::Verify::kFull), std::runtime_error);
+
+  // Truncation and foreign files are caught by the header checks
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file << "trailing";
+  }
+  EXPECT_THROW(PrimeTable::open(path, PrimeTable::Verify::kHeader), std::runtime_error);
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "definitely not a prime table, but long enough to hold a header......";
+  }
+  EXPECT_THROW(PrimeTable::open(path), std::runtime_error);
+  std::remove(path.c_str());
+
+  EXPECT_THROW(PrimeTable::open(temp_path("prime_table_missing.bin")), std::runtime_error);
+}
+
+}  // namespace
+}  // namespace ferric
@@ -0,0 +1,202 @@
+#include "prime_writer.hh"
+
+#include "number_format.hh"
+#include "prime_sieve.hh"
+
+#include <limits.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ferric {
+
+namespace {
+
+// Large enough that one writev moves megabytes, small enough that the ring
+// stays in the last-level cache between formatting and writing
+constexpr size_t kChunkBytes = size_t{1} << 18;
+constexpr size_t kRingChunks = 8;
+
+// Longest encoding of one prime: 20 digits and a newline
+constexpr size_t kMaxRecordBytes = 21;
+
+// Fixed ring of chunk buffers between the formatting thread and a writer
+// thread. Chunks are numbered by two monotonic counters: [written_, filled_)
+// are waiting to be written and the rest of the ring is free to format into.
+class ChunkWriter {
+ public:
+  explicit ChunkWriter(int fd) : fd_(fd), sizes_(kRingChunks) {
+    for (size_t i = 0; i < kRingChunks; ++i) {
+      buffers_.push_back(std::make_unique<char[]>(kChunkBytes));
+    }
+    thread_ = std::thread([this] { run(); });
+  }
+
+  ~ChunkWriter() {
+    if (thread_.joinable()) {
+      stop();
+    }
+  }
+
+  ChunkWriter(const ChunkWriter&) = delete;
+  ChunkWriter& operator=(const ChunkWriter&) = delete;
+
+  // Next free buffer of kChunkBytes, once the writer has released one
+  char* acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    released_.wait(lock, [&] { return filled_ - written_ < kRingChunks || error_; });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return buffers_[filled_ % kRingChunks].get();
+  }
+
+  // Hand the buffer from the last acquire() to the writer
+  void commit(size_t bytes) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      sizes_[filled_ % kRingChunks] = bytes;
+      ++filled_;
+    }
+    ready_.notify_one();
+  }
+
+  // Write everything committed, then rethrow the writer's error if it had one
+  void finish() {
+    stop();
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+ private:
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closing_ = true;
+    }
+    ready_.notify_one();
+    thread_.join();
+  }
+
+  void run() {
+    std::vector<iovec> iov;
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_.wait(lock, [&] { return filled_ > written_ || closing_; });
+      if (filled_ == written_) {
+        return;
+      }
+      // Every chunk filled so far goes out in one call
+      const size_t count = std::min<size_t>(filled_ - written_, IOV_MAX);
+      iov.clear();
+      for (size_t i = 0; i < count; ++i) {
+        const size_t slot = (written_ + i) % kRingChunks;
+        iov.push_back({buffers_[slot].get(), sizes_[slot]});
+      }
+      lock.unlock();
+
+      try {
+        write_all(iov);
+      } catch (...) {
+        lock.lock();
+        error_ = std::current_exception();
+        released_.notify_one();
+        return;
+      }
+
+      lock.lock();
+      written_ += count;
+      lock.unlock();
+      released_.notify_one();
+    }
+  }
+
+  // writev until every byte is out, resuming after short writes
+  void write_all(std::vector<iovec>& iov) {
+    size_t first = 0;
+    while (first < iov.size()) {
+      const ssize_t n = ::writev(fd_, iov.data() + first, static_cast<int>(iov.size() - first));
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::runtime_error(std::string("write_primes: cannot write: ") +
+                                 std::strerror(errno));
+      }
+      size_t done = static_cast<size_t>(n);
+      for (; first < iov.size() && done >= iov[first].iov_len; ++first) {
+        done -= iov[first].iov_len;
+      }
+      if (first < iov.size()) {
+        iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + done;
+        iov[first].iov_len -= done;
+      }
+    }
+  }
+
+  int fd_;
+  std::vector<std::unique_ptr<char[]>> buffers_;
+  std::vector<size_t> sizes_;
+
+  std::mutex mutex_;
+  std::condition_variable ready_;     // A chunk was committed, or closing_ was set
+  std::condition_variable released_;  // The writer freed chunks or failed
+  uint64_t filled_ = 0;
+  uint64_t written_ = 0;
+  bool closing_ = false;
+  std::exception_ptr error_;
+  std::thread thread_;
+};
+
+char* encode(uint64_t p, char* out, PrimeFormat format) {
+  if (format == PrimeFormat::kText) {
+    out = write_decimal(p, out);
+    *out = '\n';
+    return out + 1;
+  }
+  if constexpr (std::endian::native == std::endian::big) {
+    p = __builtin_bswap64(p);
+  }
+  std::memcpy(out, &p, sizeof(p));
+  return out + sizeof(p);
+}
+
+}  // namespace
+
+uint64_t write_primes(int fd, uint64_t lo, uint64_t hi, PrimeFormat format) {
+  ChunkWriter writer(fd);
+  uint64_t count = 0;
+  char* chunk = writer.acquire();
+  char* out = chunk;
+  SegmentedSieve sieve(lo, hi);
+  while (sieve.next_segment()) {
+    sieve.for_each_prime([&](uint64_t p) {
+      if (out + kMaxRecordBytes > chunk + kChunkBytes) {
+        writer.commit(out - chunk);
+        chunk = writer.acquire();
+        out = chunk;
+      }
+      out = encode(p, out, format);
+      ++count;
+    });
+  }
+  if (out != chunk) {
+    writer.commit(out - chunk);
+  }
+  writer.finish();
+  return count;
+}
+
+}  // namespace ferric
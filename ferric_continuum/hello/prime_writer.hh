@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ferric {
+
+// Encoding of the primes written by write_primes
+enum class PrimeFormat {
+  kText,    // Decimal, one prime per line
+  kBinary,  // Each prime as 8 little-endian bytes, back to back
+};
+
+// Stream the primes in [lo, hi) to fd without materializing them.
+//
+// The calling thread sieves one segment at a time and formats it straight into
+// a small ring of fixed-size chunk buffers; a writer thread flushes filled
+// chunks with writev while the next segment is sieved. Memory stays
+// O(sqrt(hi)) plus the ring, whatever the length of the range.
+//
+// fd must be open for writing and blocking; it is not closed. Returns the
+// number of primes written. Throws std::runtime_error if a write fails, after
+// which fd holds an unspecified prefix of the output.
+uint64_t write_primes(int fd, uint64_t lo, uint64_t hi, PrimeFormat format = PrimeFormat::kText);
+
+}  // namespace ferric
@@ -0,0 +1,90 @@
+#include "prime_writer.hh"
+
+#include "number_format.hh"
+#include "prime_sieve.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+std::vector<uint64_t> reference_primes(uint64_t lo, uint64_t hi) {
+  std::vector<uint64_t> primes;
+  for (uint64_t p : PrimeRange(lo, hi)) {
+    primes.push_back(p);
+  }
+  return primes;
+}
+
+// Run write_primes into a fresh file and return its contents
+std::string write_to_file(uint64_t lo, uint64_t hi, PrimeFormat format, uint64_t* count) {
+  const std::string path = testing::TempDir() + "/prime_writer_output";
+  const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  EXPECT_GE(fd, 0) << std::strerror(errno);
+  *count = write_primes(fd, lo, hi, format);
+  ::close(fd);
+  std::ifstream in(path, std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  std::remove(path.c_str());
+  return contents;
+}
+
+TEST(PrimeWriterTest, Text) {
+  // Megabytes of output, so the ring of chunks wraps many times
+  const auto primes = reference_primes(0, 20000000);
+  uint64_t count = 0;
+  const std::string text = write_to_file(0, 20000000, PrimeFormat::kText, &count);
+  EXPECT_EQ(count, primes.size());
+  std::string expected(formatted_list_size(primes, "\n") + 1, '\n');
+  format_number_list_to(primes, expected, "\n");
+  EXPECT_EQ(text, expected);
+}
+
+TEST(PrimeWriterTest, Binary) {
+  const uint64_t lo = 1000000000000;
+  const uint64_t hi = lo + 20000000;
+  const auto primes = reference_primes(lo, hi);
+  uint64_t count = 0;
+  const std::string bytes = write_to_file(lo, hi, PrimeFormat::kBinary, &count);
+  EXPECT_EQ(count, primes.size());
+  ASSERT_EQ(bytes.size(), primes.size() * 8);
+  for (size_t i = 0; i < primes.size(); ++i) {
+    uint64_t p = 0;
+    for (int b = 7; b >= 0; --b) {
+      p = p << 8 | static_cast<unsigned char>(bytes[i * 8 + b]);
+    }
+    ASSERT_EQ(p, primes[i]) << i;
+  }
+}
+
+TEST(PrimeWriterTest, EmptyAndTinyRanges) {
+  uint64_t count = 0;
+  EXPECT_EQ(write_to_file(100, 100, PrimeFormat::kText, &count), "");
+  EXPECT_EQ(count, 0);
+  EXPECT_EQ(write_to_file(24, 29, PrimeFormat::kText, &count), "");
+  EXPECT_EQ(write_to_file(0, 12, PrimeFormat::kText, &count), "2\n3\n5\n7\n11\n");
+  EXPECT_EQ(count, 5);
+}
+
+TEST(PrimeWriterTest, WriteErrorThrows) {
+  const std::string path = testing::TempDir() + "/prime_writer_read_only";
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CREAT, 0644);
+  ASSERT_GE(fd, 0);
+  EXPECT_THROW(write_primes(fd, 0, 20000000), std::runtime_error);
+  ::close(fd);
+  std::remove(path.c_str());
+}
+
+}  // namespace
+}  // namespace ferric
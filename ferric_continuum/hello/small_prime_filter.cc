@@ -0,0 +1,161 @@
+#include "small_prime_filter.hh"
+
+#include "cpu_features.hh"
+#include "primality.hh"
+
+#include <cstddef>
+#include <stdexcept>
+
+namespace ferric {
+
+namespace {
+
+// Survivors of the odd primes below 64 that lie below 67^2 are prime
+constexpr uint64_t kTrialLimit = 67 * 67;
+
+SmallPrimeVerdict screen(uint64_t n) {
+  if (n < 2 || (n % 2 == 0 && n != 2)) {
+    return SmallPrimeVerdict::kComposite;
+  }
+  for (const TrialDivisor& d : kSmallPrimeDivisors) {
+    if (d.divides(n) && n != d.p) {
+      return SmallPrimeVerdict::kComposite;
+    }
+  }
+  return n < kTrialLimit ? SmallPrimeVerdict::kPrime : SmallPrimeVerdict::kUnknown;
+}
+
+// Turn per-lane bitmasks into verdicts; lanes are in candidate order
+void emit_verdicts(unsigned composite, unsigned small, size_t lanes, SmallPrimeVerdict* out) {
+  for (size_t lane = 0; lane < lanes; ++lane) {
+    if (composite >> lane & 1) {
+      out[lane] = SmallPrimeVerdict::kComposite;
+    } else if (small >> lane & 1) {
+      out[lane] = SmallPrimeVerdict::kPrime;
+    } else {
+      out[lane] = SmallPrimeVerdict::kUnknown;
+    }
+  }
+}
+
+#ifdef FERRIC_HAVE_X86_SIMD
+
+__attribute__((target("avx512f,avx512dq"))) void filter_avx512(const uint64_t* n, size_t count,
+                                                               SmallPrimeVerdict* out) {
+  const __m512i two = _mm512_set1_epi64(2);
+  const __m512i one = _mm512_set1_epi64(1);
+  const __m512i trial_limit = _mm512_set1_epi64(kTrialLimit);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m512i v = _mm512_loadu_si512(n + i);
+    __mmask8 composite = _mm512_cmplt_epu64_mask(v, two);
+    const __mmask8 even = _mm512_testn_epi64_mask(v, one);
+    composite |= even & _mm512_cmpneq_epu64_mask(v, two);
+    for (const TrialDivisor& d : kSmallPrimeDivisors) {
+      const __m512i q = _mm512_mullo_epi64(v, _mm512_set1_epi64(static_cast<int64_t>(d.inverse)));
+      const __mmask8 divides =
+          _mm512_cmple_epu64_mask(q, _mm512_set1_epi64(static_cast<int64_t>(d.limit)));
+      composite |=
+          divides & _mm512_cmpneq_epu64_mask(v, _mm512_set1_epi64(static_cast<int64_t>(d.p)));
+    }
+    const __mmask8 small = _mm512_cmplt_epu64_mask(v, trial_limit);
+    emit_verdicts(composite, small, 8, out + i);
+  }
+  for (; i < count; ++i) {
+    out[i] = screen(n[i]);
+  }
+}
+
+// Low 64 bits of a * b per lane; AVX2 only has 32x32->64 multiplies
+__attribute__((target("avx2"))) inline __m256i mullo_epi64_avx2(__m256i a, __m256i b) {
+  const __m256i lo = _mm256_mul_epu32(a, b);
+  const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                         _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+  return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+// Lanes where a > b as unsigned 64-bit integers
+__attribute__((target("avx2"))) inline __m256i cmpgt_epu64_avx2(__m256i a, __m256i b) {
+  const __m256i sign = _mm256_set1_epi64x(static_cast<int64_t>(uint64_t{1} << 63));
+  return _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign));
+}
+
+__attribute__((target("avx2"))) void filter_avx2(const uint64_t* n, size_t count,
+                                                 SmallPrimeVerdict* out) {
+  const __m256i two = _mm256_set1_epi64x(2);
+  const __m256i one = _mm256_set1_epi64x(1);
+  const __m256i trial_max = _mm256_set1_epi64x(kTrialLimit - 1);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(n + i));
+    const __m256i is_two = _mm256_cmpeq_epi64(v, two);
+    const __m256i even = _mm256_cmpeq_epi64(_mm256_and_si256(v, one), _mm256_setzero_si256());
+    __m256i composite = _mm256_andnot_si256(cmpgt_epu64_avx2(v, one), _mm256_set1_epi64x(-1));
+    composite = _mm256_or_si256(composite, _mm256_andnot_si256(is_two, even));
+    for (const TrialDivisor& d : kSmallPrimeDivisors) {
+      const __m256i q = mullo_epi64_avx2(v, _mm256_set1_epi64x(static_cast<int64_t>(d.inverse)));
+      const __m256i above = cmpgt_epu64_avx2(q, _mm256_set1_epi64x(static_cast<int64_t>(d.limit)));
+      const __m256i is_p = _mm256_cmpeq_epi64(v, _mm256_set1_epi64x(static_cast<int64_t>(d.p)));
+      composite = _mm256_or_si256(composite, _mm256_andnot_si256(_mm256_or_si256(above, is_p),
+                                                                 _mm256_set1_epi64x(-1)));
+    }
+    const __m256i large = cmpgt_epu64_avx2(v, trial_max);
+    const unsigned composite_mask = _mm256_movemask_pd(_mm256_castsi256_pd(composite));
+    const unsigned small_mask = ~_mm256_movemask_pd(_mm256_castsi256_pd(large)) & 0xF;
+    emit_verdicts(composite_mask, small_mask, 4, out + i);
+  }
+  for (; i < count; ++i) {
+    out[i] = screen(n[i]);
+  }
+}
+
+#endif  // FERRIC_HAVE_X86_SIMD
+
+SimdLevel detect_simd_level() {
+  if (cpu_features().avx512) {
+    return SimdLevel::kAvx512;
+  }
+  if (cpu_features().avx2) {
+    return SimdLevel::kAvx2;
+  }
+  return SimdLevel::kScalar;
+}
+
+}  // namespace
+
+SimdLevel small_prime_filter_simd_level() {
+  static const SimdLevel level = detect_simd_level();
+  return level;
+}
+
+void small_prime_filter(std::span<const uint64_t> candidates,
+                        std::span<SmallPrimeVerdict> verdicts) {
+  small_prime_filter(candidates, verdicts, small_prime_filter_simd_level());
+}
+
+void small_prime_filter(std::span<const uint64_t> candidates, std::span<SmallPrimeVerdict> verdicts,
+                        SimdLevel level) {
+  if (verdicts.size() < candidates.size()) {
+    throw std::invalid_argument("small_prime_filter: verdicts is shorter than candidates");
+  }
+  if (level > small_prime_filter_simd_level()) {
+    throw std::invalid_argument("small_prime_filter: SIMD level not supported by this CPU");
+  }
+#ifdef FERRIC_HAVE_X86_SIMD
+  switch (level) {
+    case SimdLevel::kAvx512:
+      filter_avx512(candidates.data(), candidates.size(), verdicts.data());
+      return;
+    case SimdLevel::kAvx2:
+      filter_avx2(candidates.data(), candidates.size(), verdicts.data());
+      return;
+    case SimdLevel::kScalar:
+      break;
+  }
+#endif
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    verdicts[i] = screen(candidates[i]);
+  }
+}
+
+}  // namespace ferric
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace ferric {
+
+// Outcome of screening a candidate against the primes below 64
+enum class SmallPrimeVerdict : uint8_t {
+  kComposite = 0,  // Below 2, or has a small prime factor other than itself
+  kPrime = 1,      // A small prime, or below 67^2 with no small factor
+  kUnknown = 2,    // No small factor; needs a full primality test
+};
+
+// Kernels ordered by width; the best one this CPU supports is picked at runtime
+enum class SimdLevel { kScalar, kAvx2, kAvx512 };
+SimdLevel small_prime_filter_simd_level();
+
+// Screen every candidate without hardware division: p | n exactly when
+// n * p^-1 mod 2^64 <= (2^64 - 1) / p. Candidates are processed 8 (AVX-512)
+// or 4 (AVX2) lanes at a time, selected at runtime, with a scalar fallback.
+// verdicts.size() must be at least candidates.size().
+void small_prime_filter(std::span<const uint64_t> candidates,
+                        std::span<SmallPrimeVerdict> verdicts);
+
+// Same screening on an explicit kernel, which must not exceed the detected level
+void small_prime_filter(std::span<const uint64_t> candidates, std::span<SmallPrimeVerdict> verdicts,
+                        SimdLevel level);
+
+}  // namespace ferric
@@ -0,0 +1,67 @@
+#include "small_prime_filter.hh"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+namespace ferric {
+namespace {
+
+SmallPrimeVerdict expected_verdict(uint64_t n) {
+  if (n < 2)
+    return SmallPrimeVerdict::kComposite;
+  for (uint64_t p = 2; p < 64; ++p) {
+    if (n % p == 0)
+      return n == p ? SmallPrimeVerdict::kPrime : SmallPrimeVerdict::kComposite;
+  }
+  return n < 67 * 67 ? SmallPrimeVerdict::kPrime : SmallPrimeVerdict::kUnknown;
+}
+
+std::vector<uint64_t> sample_candidates() {
+  std::vector<uint64_t> candidates;
+  for (uint64_t n = 0; n < 5000; ++n) {
+    candidates.push_back(n);
+  }
+  // Wrap-around region for the n * p^-1 test and the unsigned compares
+  for (uint64_t n = 0; n < 1000; ++n) {
+    candidates.push_back(~uint64_t{0} - n);
+    candidates.push_back((uint64_t{1} << 63) + n);
+  }
+  return candidates;
+}
+
+TEST(SmallPrimeFilterTest, MatchesDivision) {
+  const auto candidates = sample_candidates();
+  std::vector<SmallPrimeVerdict> verdicts(candidates.size());
+  small_prime_filter(candidates, verdicts);
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    EXPECT_EQ(verdicts[i], expected_verdict(candidates[i])) << candidates[i];
+  }
+}
+
+TEST(SmallPrimeFilterTest, EveryKernelAgrees) {
+  // Odd lengths exercise the scalar tails after the vector loops
+  auto candidates = sample_candidates();
+  candidates.push_back(4489);
+  for (SimdLevel level : {SimdLevel::kScalar, SimdLevel::kAvx2, SimdLevel::kAvx512}) {
+    if (level > small_prime_filter_simd_level()) {
+      continue;
+    }
+    std::vector<SmallPrimeVerdict> verdicts(candidates.size());
+    small_prime_filter(candidates, verdicts, level);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      ASSERT_EQ(verdicts[i], expected_verdict(candidates[i]))
+          << candidates[i] << " level " << static_cast<int>(level);
+    }
+  }
+}
+
+TEST(SmallPrimeFilterTest, RejectsShortOutput) {
+  std::vector<uint64_t> candidates = {1, 2, 3};
+  std::vector<SmallPrimeVerdict> verdicts(2);
+  EXPECT_THROW(small_prime_filter(candidates, verdicts), std::invalid_argument);
+}
+
+}  // namespace
+}  // namespace ferric
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ferric {
+
+// Fixed-size pool of worker threads draining a FIFO task queue.
+//
+// Tasks are submitted as callables and their results come back through
+// std::future. The destructor finishes every queued task before joining.
+class ThreadPool {
+ public:
+  // num_threads == 0 means one worker per hardware thread
+  explicit ThreadPool(size_t num_threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t size() const { return workers_.size(); }
+
+  template <typename F>
+  std::future<std::invoke_result_t<F>> submit(F&& task);
+
+ private:
+  void enqueue(std::function<void()> task);
+  void worker_loop();
+  void stop_and_join();
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::queue<std::function<void()>> tasks_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+// Wait for every task, then rethrow the first error in submission order.
+// Tasks usually reference the caller's frame, so all of them finish before
+// any error propagates.
+void wait_all(std::vector<std::future<void>>& tasks);
+
+template <typename F>
+std::future<std::invoke_result_t<F>> ThreadPool::submit(F&& task) {
+  // std::function needs a copyable target, so the move-only packaged_task is shared
+  auto packaged =
+      std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(task));
+  auto result = packaged->get_future();
+  enqueue([packaged] { (*packaged)(); });
+  return result;
+}
+
+}  // namespace ferric
@@ -0,0 +1,57 @@
+#include "thread_pool.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+
+namespace ferric {
+namespace {
+
+TEST(ThreadPoolTest, DefaultsToHardwareThreads) {
+  ThreadPool pool;
+  EXPECT_GE(pool.size(), 1);
+}
+
+TEST(ThreadPoolTest, ReturnsResults) {
+  ThreadPool pool(3);
+  std::vector<std::future<int>> results;
+  for (int i = 0; i < 100; ++i) {
+    results.push_back(pool.submit([i] { return i * i; }));
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(results[i].get(), i * i);
+  }
+}
+
+TEST(ThreadPoolTest, PropagatesExceptions) {
+  ThreadPool pool(2);
+  auto result = pool.submit([]() -> int { throw std::runtime_error("boom"); });
+  EXPECT_THROW(result.get(), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, WaitAllFinishesEveryTaskBeforeRethrowing) {
+  ThreadPool pool(2);
+  std::atomic<int> finished = 0;
+  std::vector<std::future<void>> tasks;
+  tasks.push_back(pool.submit([] { throw std::runtime_error("first"); }));
+  for (int i = 0; i < 100; ++i) {
+    tasks.push_back(pool.submit([&finished] { finished.fetch_add(1); }));
+  }
+  EXPECT_THROW(wait_all(tasks), std::runtime_error);
+  EXPECT_EQ(finished.load(), 100);
+}
+
+TEST(ThreadPoolTest, DrainsQueueOnDestruction) {
+  std::atomic<int> counter = 0;
+  {
+    ThreadPool pool(2);
+    for (int i = 0; i < 1000; ++i) {
+      pool.submit([&counter] { counter.fetch_add(1); });
+    }
+  }
+  EXPECT_EQ(counter.load(), 1000);
+}
+
+}  // namespace
+}  // namespace ferric